@@ -12,15 +12,30 @@
   #define SL_STACK_SIZE  4096
 #endif
 
+// <q SL_HEAP_FREE> Build without a heap
+// <i> Default: 1
+// <i> Guarantees that nothing allocates dynamically. The heap is 0 bytes and its
+// <i> RAM is given to the static buffers sized with RAM_HEAP_RECLAIMED (ram.h).
+// <i> linkerfile.ld fails the link if malloc(), calloc() or realloc() is
+// <i> referenced while the heap is empty.
+#ifndef SL_HEAP_FREE
+  #define SL_HEAP_FREE   1
+#endif
+
 // <o SL_HEAP_SIZE> Minimum heap size for the application.
 // <i> Default: 2048
 // <i> Note that this value will configure the c heap which is normally used by
 // <i> malloc() and free() from the c library. The value defines a minimum heap
 // <i> size that is guaranteed to be available. The available heap may be larger
 // <i> to make use of any memory that would otherwise remain unused.
+// <i> Forced to 0 by SL_HEAP_FREE.
 #ifndef SL_HEAP_SIZE
+#if SL_HEAP_FREE
+  #define SL_HEAP_SIZE   0
+#else
   #define SL_HEAP_SIZE   2048
 #endif
+#endif
 
 // </h>
 // <<< end of configuration section >>>
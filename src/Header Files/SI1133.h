@@ -11,8 +11,8 @@
 #include "i2c.h"
 #include "brd_config.h"
 #include "HW_delay.h"
+#include "sensor.h"
 
-#define   NULL_CB           0x00         //0b0000
 #define   RESET_CMD_CNT     0x00
 #define   PART_ID_REGISTER  0x00  //Register address for Part ID
 #define   RESPONSE0         0x11
@@ -24,6 +24,7 @@
 #define   CHANNEL0_PREP     0b000001
 #define   CHAN_LIST         0x01
 #define   FORCE             0x11 //force command
+#define   PAUSE             0x12 //pause command, stops any autonomous measurements
 #define   HOSTOUT0          0x13
 #define   HOSTOUT1          0x14
 #define   HOSTOUT2          0x15
@@ -31,6 +32,10 @@
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+#define   SI1133_SENSOR_ID  0
+#define   SI1133_QUIET_MS   2    //FORCE write at the I2C rate and the white light conversion
+
+extern const SENSOR_OPS si1133_sensor_ops;
 
 
 //***********************************************************************************
@@ -42,5 +47,6 @@ void si1133_write(uint32_t bytes_expected, uint32_t desired_register_address, ui
 void si1133_force_cmd();
 void si1133_read_white_light(uint32_t light_cb);
 uint32_t si1133_read_result();
+void si1133_power_down();
 
 #endif /* HEADER_FILES_SI1133_H_ */
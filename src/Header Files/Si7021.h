@@ -0,0 +1,43 @@
+/*
+ * Si7021.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: adamv
+ */
+
+#ifndef HEADER_FILES_SI7021_H_
+#define HEADER_FILES_SI7021_H_
+
+#include "i2c.h"
+#include "brd_config.h"
+#include "HW_delay.h"
+#include "sensor.h"
+
+#define   SI7021_ADDRESS        0x40
+#define   SI7021_MEASURE_RH     0xF5  //measure relative humidity, no hold master mode
+#define   SI7021_READ_PREV_TEMP 0xE0  //read temperature value measured with the previous RH measurement
+#define   SI7021_RESET          0xFE
+#define   SI7021_RESET_DELAY    15    //ms for the device to power up after a reset
+#define   SI7021_RH_BYTES       2
+#define   SI7021_TEMP_BYTES     2
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+#define   SI7021_RH_SENSOR_ID   1
+#define   SI7021_TEMP_SENSOR_ID 2
+
+extern const SENSOR_OPS si7021_rh_sensor_ops;
+extern const SENSOR_OPS si7021_temp_sensor_ops;
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void si7021_open(void);
+void si7021_measure_rh(void);
+void si7021_read_rh(uint32_t rh_cb);
+void si7021_read_temp(uint32_t temp_cb);
+int32_t si7021_rh_result(void);
+int32_t si7021_temp_result(void);
+
+#endif /* HEADER_FILES_SI7021_H_ */
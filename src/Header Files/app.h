@@ -19,20 +19,86 @@
 #include "brd_config.h"
 #include "scheduler.h"
 #include "sleep_routines.h"
+#include "power.h"
+#include "ulfrco_cal.h"
+#include "log.h"
+#include "detect.h"
 #include "LEDs_thunderboard.h"
 #include "SI1133.h"
+#include "Si7021.h"
+#include "sensor.h"
+#include "rules.h"
+#include "cyclic_exec.h"
 #include "ble.h"
+#include "dma.h"
+#include "governor.h"
+#include "mx25.h"
+#include "replay.h"
 #include "HW_Delay.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-#define   PWM_PER             2.0   // PWM period in seconds
-#define   PWM_ACT_PER         .002  // PWM active period in seconds
+#define   PWM_PER             2.0   // PWM period in seconds, the fastest sample period the governor chooses
+#define   PWM_ACT_PER         .05   // PWM active period in seconds, length of the heartbeat flash
 #define   READ_BYTES          1     //Number of bytes we want to read from si1133
-#define   EXPECTED_READ_DATA  20    //Part ID value expected to return from read
+#define   APP_RULE_DARK       1     //rule id in tools/rules.cfg that drives the BLUE LED
+#define   APP_RULE_TRANSITIONS 4    //rule transitions reported from a single sample
+#define   APP_ALERT_MAX_AGE_MS(period_ms) ((period_ms) * 7 / 4) //rules wait for the collect in progress, not the last period's sample
+#define   APP_LED_MAX_AGE_MS(period_ms)   ((period_ms) * 2 + 500) //the LED duty may lag a period, it never waits
+#define   APP_HOST_MAX_AGE_MS(period_ms)  ((period_ms) * 2 + 500) //the host sees HOST_REG_TIMESTAMP, the map never waits
+#define   APP_CACHE_REPORT_MS 600000 //time between logs of the sensor cache telemetry
+#define   DETECT_FAST_PER     0.25  //sample period in seconds while a light change point is captured
+#define   DETECT_LIGHT_Z      4     //standard deviations from the light baseline that start a capture
+#define   DETECT_LIGHT_SIGMA  5     //si1133 counts, noise floor of the light baseline
+#define   DETECT_LIGHT_SHIFT  4     //light baseline averages over 2^4 samples
+#define   DETECT_LIGHT_WARMUP 16    //samples before the light baseline may fire
+#define   HOST_I2C_ADDRESS    0x55  //7 bit slave address the host polls
+
+// Register map served to the host over I2C, multi byte values are little endian
+#define   HOST_REG_STATUS     0x00  //bit 0 dark rule active, bit 1 log replay running
+#define   HOST_REG_VERSION    0x01  //HOST_MAP_VERSION
+#define   HOST_REG_LIGHT      0x02  //int32 si1133 white light, counts
+#define   HOST_REG_RH         0x06  //int32 si7021 humidity, 0.01 %RH
+#define   HOST_REG_TEMP       0x0A  //int32 si7021 temperature, 0.01 C
+#define   HOST_REG_TIMESTAMP  0x0E  //uint32 ms the last sample was taken
+#define   HOST_REG_SAMPLES    0x12  //uint32 samples collected
+#define   HOST_REG_SERVED     0x16  //uint32 register bytes read by the host
+#define   HOST_REG_SIZE       0x1A
+#define   HOST_MAP_VERSION    1
+#define   HOST_STATUS_DARK    0x01
+#define   HOST_STATUS_REPLAY  0x02
 #define   SYSTEM_BLOCK_EM     EM3
+//#define   CYCLIC_EXECUTIVE_ENABLED      // run the periodic jobs from the frame table in cyclic_schedule.c
+#define   APP_CYCLIC_REPORT_MS 60000    //time between the overrun and jitter reports of the cyclic executive
+#define   INDICATION_DEFAULT  indication_heartbeat
+#define   INDICATION_LIGHT_FULL_SCALE 1000  // si1133 white light counts shown as a 100% duty cycle
+//#define   LOG_REPLAY_ON_BOOT            // stream LOG_REPLAY_LENGTH bytes of the SPI flash over bluetooth after boot
+#define   LOG_REPLAY_ADDRESS  0x000000
+#define   LOG_REPLAY_LENGTH   4096
+//#define   HISTORY_LTTB_ON_BOOT          // send HISTORY_OUT_POINTS points downsampled from the history records after boot
+#define   HISTORY_ADDRESS     0x010000  //first {uint32 ms, int32 value} history record in the SPI flash, programmed from the host, an erased region ends the query
+#define   HISTORY_POINTS      86400     //one day of 1 s records
+#define   HISTORY_OUT_POINTS  500
+//#define   LTTB_BENCHMARK_ON_BOOT        // log the cycles per point of LTTB over synthetic inputs before starting
+#define   LTTB_BENCH_OUT_POINTS 500
+#define   BLE_PROFILE_DEFAULT ble_profile_low_power_idle  //radio profile, also the one replays run on
+
+// Energy budget governor, the charges are bench estimates for this board and firmware, see governor.h
+#define   APP_BATTERY_UAH     2400000   //2 x AA alkaline, usable charge
+#define   APP_LIFETIME_DAYS   365       //deployment the battery has to last
+#define   APP_EM0_UA          1700      //EM0/EM1 with the DCDC in discontinuous conduction
+#define   APP_EM0_QUIET_UA    2000      //EM0/EM1 with the DCDC in continuous conduction
+#define   APP_EM23_UA         4         //EM2/EM3 with the LETIMER, LFXO and CRYOTIMER running
+#define   APP_BASE_UA         200       //HM10 in the low power idle profile, sensors in standby
+#define   APP_SAMPLE_NC       30000     //si1133 and si7021 conversions of one sample cycle
+#define   APP_FRAME_NC        40000     //HM10 wake up and connection event for one frame
+#define   APP_BYTE_NC         1500      //HM10 UART and radio time of one byte
+#define   APP_GOV_WINDOW_MS   60000     //time between adjustments
+#define   APP_GOV_HORIZON_MS  86400000  //a reserve or deficit is evened out over a day
+#define   APP_PERIOD_MAX_MS   30000     //slowest sample period
+#define   APP_COALESCE_MAX_MS 60000     //longest log records are held to share a frame
 
 
 //***********************************************************************************
@@ -42,9 +108,42 @@
 #define   LETIMER0_COMP0_CB     0x00000001   //0b0001
 #define   LETIMER0_COMP1_CB     0x00000002   //0b0010
 #define   LETIMER0_UF_CB        0x00000004   //0b0100
-#define   SI1133_LIGHT_CB       0x00000008   //0b1000
+#define   SENSOR_COLLECT_CB     0x00000008   //0b1000
 #define   BOOT_UP_CB            0x00000010  //0b10000
 #define   BLE_TX_DONE_CB        0x00000020
+#define   CYCLIC_FRAME_CB       0x00000040
+#define   REPLAY_FILL_CB        0x00000080
+#define   REPLAY_DRAIN_CB       0x00000100
+#define   REPLAY_DONE_CB        0x00000200
+#define   SENSOR_READ_CB        0x00000400
+#define   LOG_TX_DONE_CB        0x00000800
+#define   BLE_RX_CB             0x00001000
+
+// Status LED patterns driven directly by the LETIMER0 PWM outputs
+typedef enum {
+  indication_off,
+  indication_heartbeat,       // green flash of PWM_ACT_PER every period
+  indication_light_level,     // green duty cycle follows the si1133 white light reading
+  indication_error_blink,     // red on for half of every period
+  indication_error_solid      // red on continuously
+}
+INDICATION_MODE;
+
+// Consumers of the sensor readings, each reads through the sensor cache with its own age limit
+typedef enum {
+  app_consumer_alerts,        // alert rules and the light change-point detector, every sample once
+  app_consumer_led,           // light level indication
+  app_consumer_host           // I2C register map served to the host
+}
+APP_CONSUMER;
+
+typedef struct {
+  APP_CONSUMER  consumer;
+  uint32_t      sensor_id;
+  uint32_t      timestamp;    // trigger time of the last sample the consumer took
+  bool          taken;
+  bool          waiting;      // missed the cache, released by SENSOR_READ_CB
+} APP_SENSOR_READ;
 
 
 
@@ -58,9 +157,19 @@ void app_peripheral_setup(void);
 void scheduled_letimer0_uf_cb (void);
 void scheduled_letimer0_comp0_cb (void);
 void scheduled_letimer0_comp1_cb (void);
-void scheduled_si1133_read_cb(void);
+void scheduled_sensor_collect_cb(void);
+void scheduled_sensor_read_cb(void);
 void scheduled_boot_up_cb(void);
 void scheduled_ble_tx_done_cb(void);
+void scheduled_ble_rx_cb(void);
+void scheduled_replay_fill_cb(void);
+void scheduled_replay_drain_cb(void);
+void scheduled_replay_done_cb(void);
+void scheduled_log_tx_done_cb(void);
+void scheduled_cyclic_frame_cb(void);
 void rgb_led_open(void);
+void app_indication_set(INDICATION_MODE mode);
+void app_job_sensor_sample(void);
+void app_job_report(void);
 
 #endif
@@ -17,16 +17,77 @@
 // Driver functions
 #include "leuart.h"
 #include "gpio.h"
+#include "letimer.h"
 #include "brd_config.h"
 
 
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define BLE_CONN_PARAMS_SUPPORTED       // comment out for HM10 firmware without AT+COMI/COMA/COLA/COUP
+#define BLE_AT_TIMEOUT_MS     1000      // no reply to an AT command in this long means a central is connected
+#define BLE_AT_RESET_MS       1000      // module boot time after AT+RESET, no commands are sent until it has passed
+#define BLE_AT_RESPONSE_MAX   16        // longest reply the parser holds, "OK+Set:x" is 8
+
+/*
+ * Radio profiles, applied through the HM10 AT commands. The module only takes AT commands while no central is
+ * connected, anything sent over the UART while connected is forwarded to the central. A profile requested while
+ * connected is held and applied once the module reports OK+LOST (AT+NOTI1 is part of every profile). The advertising
+ * interval and TX power take effect after AT+RESET, which is sent once at the end of an apply. The connection
+ * interval and slave latency are what the module asks the central for after the next connection (AT+COUP1).
+ *
+ * A replay may start while a central is connected, and a profile cannot change the interval of a connection that is
+ * already up, so the app does not switch profiles around replays. Replays run on the profile the central connected
+ * under, which is why the connection interval of the low power idle profile is short enough to carry a replay at the
+ * full LEUART rate and the slave latency keeps its idle cost down. The bulk transfer profile only helps when it is
+ * set before the central connects. Frames are held while ble_at_busy() so they never land inside an AT exchange.
+ *
+ *   code   AT+ADVI           AT+POWE     AT+COMI / AT+COMA
+ *   0      100 ms            -23 dBm     7.5 ms
+ *   1      152.5 ms          -6 dBm      10 ms
+ *   2      211.25 ms         0 dBm       15 ms
+ *   3      318.75 ms         6 dBm       20 ms
+ *   5      546.25 ms                     30 ms
+ *   7      852.5 ms                      40 ms
+ *   9      1285 ms                       4000 ms
+ *
+ * tools/hm10_sim.py simulates the link for each profile and reports its throughput and latency.
+ */
+
 
 //***********************************************************************************
 // global variables
 //***********************************************************************************
+typedef enum {
+  ble_profile_low_power_idle,     // slow advertising, low TX power, slave latency on a replay capable interval
+  ble_profile_interactive,        // quick to connect, short connection interval for command round trips
+  ble_profile_bulk_transfer,      // shortest connection interval and full TX power, set before a central connects for long uploads
+  ble_profile_count
+}
+BLE_PROFILE;
+
+typedef enum {
+  ble_param_notify,               // AT+NOTI, reports OK+CONN / OK+LOST
+  ble_param_adv_interval,         // AT+ADVI
+  ble_param_tx_power,             // AT+POWE
+#ifdef BLE_CONN_PARAMS_SUPPORTED
+  ble_param_conn_min,             // AT+COMI
+  ble_param_conn_max,             // AT+COMA
+  ble_param_conn_latency,         // AT+COLA, connection events the module may skip
+  ble_param_conn_update,          // AT+COUP, ask the central for the interval after connecting
+#endif
+  ble_param_count
+}
+BLE_PARAM;
+
+typedef struct {
+  uint32_t      switches;         // profiles fully applied to the module
+  uint32_t      commands;         // AT commands sent, including AT+RESET
+  uint32_t      skipped;          // parameters already at the requested value, no command sent
+  uint32_t      deferred;         // requests held while a central was connected
+  uint32_t      timeouts;         // commands without a reply
+  uint32_t      rejected;         // replies that did not echo the value sent
+} BLE_PROFILE_STATS;
 
 
 //***********************************************************************************
@@ -34,6 +95,14 @@
 //***********************************************************************************
 void ble_open(uint32_t tx_event, uint32_t rx_event);
 void ble_write(char *string);
+void ble_profile_set(BLE_PROFILE profile);
+BLE_PROFILE ble_profile_get(void);
+bool ble_profile_applied(void);
+bool ble_connected(void);
+bool ble_at_busy(void);
+void ble_rx_service(void);
+void ble_profile_poll(void);
+void ble_profile_stats(BLE_PROFILE_STATS *stats);
 
 bool ble_test(char *mod_name);
 
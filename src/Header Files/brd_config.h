@@ -38,8 +38,8 @@
 
 // LETIMER PWM Configuration
 
-#define   PWM_ROUTE_0     LETIMER_ROUTELOC0_OUT0LOC_LOC17
-#define   PWM_ROUTE_1     LETIMER_ROUTELOC0_OUT1LOC_LOC16
+#define   PWM_ROUTE_0     LETIMER_ROUTELOC0_OUT0LOC_LOC17   // PD9, LED_GREEN
+#define   PWM_ROUTE_1     LETIMER_ROUTELOC0_OUT1LOC_LOC16   // PD8, LED_RED
 
 
 // RGB LED locations
@@ -81,6 +81,16 @@
 #define I2C_SCL_PC5   I2C_ROUTELOC0_SCLLOC_LOC17
 #define I2C_SDA_PC4   I2C_ROUTELOC0_SDALOC_LOC17
 
+// Host I2C slave locations (I2C0 on the expansion header, pin 15 SCL, pin 16 SDA)
+#define HOST_I2C          I2C0
+#define HOST_SCL_PORT     gpioPortC
+#define HOST_SCL_PIN      11
+#define HOST_SDA_PORT     gpioPortC
+#define HOST_SDA_PIN      10
+#define HOST_I2C_DEFAULT  true
+#define I2C_SCL_PC11      I2C_ROUTELOC0_SCLLOC_LOC15
+#define I2C_SDA_PC10      I2C_ROUTELOC0_SDALOC_LOC15
+
 // LEUART Locations
 #define LEUART_RX_PORT gpioPortF
 #define LEUART_RX_PIN 4
@@ -91,6 +101,22 @@
 #define LEUART_DRIVE_STRENGTH gpioDriveStrengthStrongAlternateWeak
 #define LEUART_DEFAULT true
 
+// MX25 SPI flash locations (USART2, see config/sl_mx25_flash_shutdown_usart_config.h)
+#define MX25_SPI_USART  USART2
+#define MX25_MOSI_PORT  gpioPortK
+#define MX25_MOSI_PIN   0
+#define MX25_MISO_PORT  gpioPortK
+#define MX25_MISO_PIN   2
+#define MX25_SCLK_PORT  gpioPortF
+#define MX25_SCLK_PIN   7
+#define MX25_CS_PORT    gpioPortK
+#define MX25_CS_PIN     1
+#define MX25_MOSI_ROUTE USART_ROUTELOC0_TXLOC_LOC29
+#define MX25_MISO_ROUTE USART_ROUTELOC0_RXLOC_LOC30
+#define MX25_SCLK_ROUTE USART_ROUTELOC1_CLKLOC_LOC18
+#define MX25_CS_DEFAULT true    // chip select idles high (deselected)
+#define MX25_DEFAULT    false
+
 //BLE Enums
 #define HM10_LEUART0  LEUART0
 #define HM10_BAUDRATE  9600 // 3 is bits corresponding to 9600
@@ -0,0 +1,51 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef CYCLIC_EXEC_HG
+#define CYCLIC_EXEC_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "letimer.h"
+#include "cyclic_schedule.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define CYCLIC_END    0xFF    // terminates the job list of a frame
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+/*
+ * The frame table (cyclic_schedule.h/.c) is generated from tools/cyclic_schedule.cfg by
+ * tools/gen_cyclic_schedule.py, which fails if the declared worst case execution times
+ * of any minor frame do not fit in the frame:
+ *   python3 tools/gen_cyclic_schedule.py tools/cyclic_schedule.cfg \
+ *     "src/Header Files/cyclic_schedule.h" "src/Source Files/cyclic_schedule.c"
+ */
+typedef struct {
+  void      (*handler)(void);
+  uint32_t  wcet_us;        // declared worst case execution time
+} CYCLIC_JOB;
+
+extern const CYCLIC_JOB cyclic_jobs[CYCLIC_JOBS];
+extern const uint8_t    cyclic_frames[CYCLIC_MINOR_FRAMES][CYCLIC_FRAME_SLOTS];
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void cyclic_exec_open(void);
+void cyclic_exec_frame(uint32_t tick, uint32_t release_ms);
+uint32_t cyclic_exec_overruns(void);
+uint32_t cyclic_exec_max_jitter_ms(uint32_t job);
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file
+ * cyclic_schedule.h
+ * @brief
+ * Cyclic executive frame table, generated by tools/gen_cyclic_schedule.py from cyclic_schedule.cfg.
+ * Do not edit, change the schedule file and regenerate.
+ *
+ * minor frame 500 ms, major frame 2000 ms, margin 20000 us
+ * frame 0:   1500 us of 500000 us (app_job_sensor_sample)
+ * frame 1:      0 us of 500000 us (idle)
+ * frame 2:  65000 us of 500000 us (app_job_report)
+ * frame 3:      0 us of 500000 us (idle)
+ */
+
+#ifndef CYCLIC_SCHEDULE_HG
+#define CYCLIC_SCHEDULE_HG
+
+#define CYCLIC_MINOR_FRAME_MS  500
+#define CYCLIC_MINOR_FRAMES    4
+#define CYCLIC_FRAME_SLOTS     2
+#define CYCLIC_JOBS            2
+
+#endif
@@ -0,0 +1,95 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef DETECT_HG
+#define DETECT_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "sensor.h"
+#include "log.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define DETECT_PRE_SAMPLES    8         // samples kept from before the trigger
+#define DETECT_POST_SAMPLES   16        // samples captured from the trigger on, at the fast rate
+#define DETECT_MEAN_FRAC      4         // baseline mean is kept in Q4
+#define DETECT_MAX_VALUE      (1 << 26) // |sample| the Q4 mean and the squared deviation can hold
+
+/*
+ * Change-point test on an exponential moving baseline, all integer:
+ *
+ *   d     = x - mean                              (Q4)
+ *   mean += d >> ema_shift
+ *   var  += (d * d - var) >> ema_shift            (Q8, 64 bit)
+ *   fire when d * d > z^2 * max(var, min_sigma^2)    (tested as d * d / z^2, the product can pass 64 bits)
+ *
+ * i.e. when the sample is more than z standard deviations from the baseline. ema_shift 4 averages over ~16 samples
+ * (32 s at the 2 s period). The baseline is frozen while capturing and is restarted from the last captured sample
+ * afterwards, so a step (a light switched on) fires once and a transient (a shadow passing) fires once.
+ *
+ * A report is the trigger record and one record per captured sample, sent through LOG():
+ *   "event %d z %d base %d sigma %d"   sensor, z, baseline, standard deviation of the baseline
+ *   "evt %d ms = %d"                   ms from the trigger (negative before it), value
+ * 10 bytes per sample on the wire, 250 bytes for the 24 sample window.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  detect_idle,                    // sample folded into the baseline
+  detect_triggered,               // this sample fired, the caller raises the sample rate
+  detect_capturing,               // sample stored in the post trigger window
+  detect_done                     // window complete, the caller restores the rate and sends detect_report()
+}
+DETECT_RESULT;
+
+typedef struct {
+  uint32_t      sensor_id;        // only samples of this sensor are tested
+  uint32_t      ema_shift;        // baseline time constant, 2^ema_shift samples
+  uint32_t      z_threshold;      // standard deviations from the baseline that fire
+  uint32_t      min_sigma;        // floor of the standard deviation, sample units, keeps a quiet sensor from firing on noise
+  uint32_t      warmup;           // samples folded into the baseline before it may fire
+} DETECT_OPEN_STRUCT;
+
+typedef struct {
+  int32_t       value;
+  uint32_t      timestamp;
+} DETECT_POINT;
+
+typedef struct {
+  DETECT_OPEN_STRUCT  cfg;
+  int32_t             mean;       // Q4
+  int64_t             var;        // Q8
+  uint32_t            samples;    // since the baseline was (re)started
+  bool                capturing;
+  DETECT_POINT        pre[DETECT_PRE_SAMPLES];   // ring of the samples before the trigger
+  uint32_t            pre_head;
+  uint32_t            pre_count;
+  DETECT_POINT        post[DETECT_POST_SAMPLES];
+  uint32_t            post_count;
+  uint32_t            z;          // standard deviations of the trigger from the baseline
+  int32_t             trigger_mean;
+  uint32_t            trigger_sigma;
+  uint32_t            events;
+} DETECT_STATE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void detect_open(DETECT_STATE *detect, const DETECT_OPEN_STRUCT *detect_setup);
+DETECT_RESULT detect_sample(DETECT_STATE *detect, const SENSOR_SAMPLE *sample);
+void detect_report(DETECT_STATE *detect);
+
+#endif
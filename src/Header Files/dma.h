@@ -0,0 +1,113 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef DMA_HG
+#define DMA_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_ldma.h"
+#include "em_core.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+#include "sleep_routines.h"
+#include "letimer.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define DMA_CHANNELS        DMA_CHAN_COUNT      // 8 LDMA channels on the EFR32MG12
+#define DMA_MAX_XFER        2048                // max units a single LDMA descriptor can move
+#define DMA_EM_NONE         MAX_ENERGY_MODES    // em_block of a channel that does not limit sleep
+
+/*
+ * Drivers no longer own LDMA channel numbers. A driver takes a channel with dma_channel_alloc() when it is opened and
+ * says what happens when a transfer on it is done: a function run from the LDMA IRQ (to start the next piece of a
+ * driver state machine) and/or an event for the scheduler. The descriptors are built with the DMA_CHAIN functions into
+ * storage the driver keeps, since the LDMA reads them while the transfer runs:
+ *
+ *   linked      dma_chain_add() as many times as needed, lengths above DMA_MAX_XFER are split, done on the last
+ *   circular    dma_chain_loop() links the last descriptor back, the chain runs until dma_stop()
+ *   ping-pong   dma_chain_ping_pong(), two buffers in a circle, done (and the callbacks) after each one
+ *
+ * The energy mode block of a channel is only held from dma_start() until the transfer is done or stopped, so an idle
+ * channel never keeps the device out of EM2/EM3. A transfer whose completion is taken from the peripheral (its
+ * descriptors have doneIfs cleared, ex. LEUART TXC) is finished by the driver with dma_done().
+ *
+ * dma_stats() reports each channel's active time as a share of the time since dma_open(), and how long more than one
+ * channel was active at once, which is when the channels compete for the LDMA and the bus. Times are taken with
+ * letimer_time_ms(), so a single short transfer may count as 0 or 1 ms but the totals are right on average.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  dma_mem_to_periph,              // source increments, destination is a peripheral register
+  dma_periph_to_mem,              // source is a peripheral register, destination increments
+  dma_mem_to_mem                  // both increment
+}
+DMA_DIRECTION;
+
+typedef struct {
+  void          (*done_func)(void *ctx);  // called from the LDMA IRQ on every done interrupt, may be NULL
+  void          *ctx;
+  uint32_t      done_cb;          // event scheduled on every done interrupt, 0 for none
+  uint32_t      em_block;         // energy mode blocked while a transfer is active, DMA_EM_NONE for none
+} DMA_CHANNEL_OPEN;
+
+typedef struct {
+  LDMA_Descriptor_t *desc;        // driver storage, read by the LDMA until the transfer is done
+  uint32_t      count;
+  uint32_t      max;
+  LDMA_CtrlSize_t size;
+  uint32_t      bytes;            // moved by one pass through the chain
+  uint32_t      done_points;      // descriptors that raise a done interrupt
+  bool          loop;
+} DMA_CHAIN;
+
+typedef struct {
+  bool          allocated;
+  bool          active;
+  uint32_t      transfers;        // transfers done or stopped, passes of a ping-pong half
+  uint32_t      bytes;
+  uint32_t      active_ms;
+  uint32_t      util_permille;    // active_ms over the time since dma_open()
+} DMA_CHANNEL_STATS;
+
+typedef struct {
+  DMA_CHANNEL_STATS channel[DMA_CHANNELS];
+  uint32_t      allocated;
+  uint32_t      peak_active;      // most channels active at once
+  uint32_t      concurrent_ms;    // time with more than one channel active
+  uint32_t      elapsed_ms;
+} DMA_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void dma_open(void);
+uint32_t dma_channel_alloc(const DMA_CHANNEL_OPEN *setup);
+void dma_channel_free(uint32_t ch);
+void dma_chain_init(DMA_CHAIN *chain, LDMA_Descriptor_t *desc, uint32_t max, LDMA_CtrlSize_t size);
+void dma_chain_add(DMA_CHAIN *chain, DMA_DIRECTION direction, const volatile void *src, volatile void *dst,
+                   uint32_t count);
+void dma_chain_loop(DMA_CHAIN *chain, uint32_t first);
+void dma_chain_ping_pong(DMA_CHAIN *chain, DMA_DIRECTION direction, volatile void *periph, void *buf_a, void *buf_b,
+                         uint32_t count);
+void dma_start(uint32_t ch, const LDMA_TransferCfg_t *cfg, const DMA_CHAIN *chain);
+void dma_done(uint32_t ch);
+void dma_stop(uint32_t ch);
+bool dma_active(uint32_t ch);
+void dma_stats(DMA_STATS *stats);
+void LDMA_IRQHandler(void);
+
+#endif
@@ -0,0 +1,57 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef FRAME_HG
+#define FRAME_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+/*
+ * Binary frame sent over the LEUART link, built in place around a payload:
+ *
+ *   offset  size  field
+ *   0       1     FRAME_SYNC0
+ *   1       1     FRAME_SYNC1
+ *   2       1     type (FRAME_TYPE)
+ *   3       1     sequence number, wraps at 256
+ *   4       2     payload length, little endian
+ *   6       len   payload
+ *   6+len   4     CRC-32 (IEEE 802.3, reflected, as zlib) of type through the end of the payload, little endian
+ *
+ * A receiver that loses sync scans for FRAME_SYNC0 FRAME_SYNC1 and accepts the frame only if the CRC matches.
+ */
+#define FRAME_SYNC0           0xA5
+#define FRAME_SYNC1           0x5A
+#define FRAME_HEADER_SIZE     6
+#define FRAME_TRAILER_SIZE    4
+#define FRAME_OVERHEAD        (FRAME_HEADER_SIZE + FRAME_TRAILER_SIZE)
+#define FRAME_PAYLOAD_MAX     1024
+#define FRAME_SIZE(payload)   ((payload) + FRAME_OVERHEAD)
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  frame_type_replay = 1,          // raw bytes replayed from the SPI flash
+  frame_type_log = 2,             // log records, decoded on the host by tools/log_decode.py
+  frame_type_history = 3          // downsampled history, 8 byte points {uint32 ms, int32 value} little endian
+}
+FRAME_TYPE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+uint32_t frame_seal(uint8_t *frame, FRAME_TYPE type, uint8_t seq, uint32_t payload_len);
+uint32_t frame_crc32(uint32_t crc, const uint8_t *data, uint32_t length);
+
+#endif
@@ -0,0 +1,121 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef GOVERNOR_HG
+#define GOVERNOR_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "letimer.h"
+#include "power.h"
+#include "sensor.h"
+#include "log.h"
+#include "replay.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define GOVERNOR_LEVEL_FULL       1000      // level of the bounds that give the most data
+#define GOVERNOR_GAIN_PERMILLE    500       // share of the relative current error corrected per window
+#define GOVERNOR_HYST_PERMILLE    50        // relative current error left alone, keeps the level from hunting
+#define GOVERNOR_STEP_MAX         250       // most the level moves in one window
+#define GOVERNOR_NC_PER_UAH       3600000   // 1 uAh = 3.6 mC
+
+/*
+ * Charge is counted in nC (uA * ms) from what the firmware already measures:
+ *
+ *   window charge = sum over power states of state_ms * state_ua      (power_stats(), EM0/EM1 time includes LDMA work)
+ *                 + window_ms * base_ua                                (radio module idle, sensors in standby)
+ *                 + sample cycles * sample_nc                          (governor_sample_cycle())
+ *                 + radio frames * frame_nc + radio bytes * byte_nc    (log_stats() and replay_stats())
+ *
+ * The currents and charges are estimates measured once on the bench for this board. The budget is a straight line
+ * from the full capacity at governor_open() to empty at lifetime_days. At the end of every window the charge used is
+ * compared with that line, and the difference (the reserve) is spread over the next horizon_ms:
+ *
+ *   target = capacity / lifetime + reserve / horizon_ms
+ *   level += GOVERNOR_GAIN_PERMILLE * (target - window current) / target       (ignored inside GOVERNOR_HYST_PERMILLE)
+ *
+ * The level (0 to GOVERNOR_LEVEL_FULL) sets the three knobs between their bounds. At the full level the firmware runs
+ * as it did without the governor: the shortest period, no deadband and no coalescing.
+ *
+ *   sample period   period_min_ms to period_max_ms, interpolated in rate so the current moves about linearly with level
+ *   deadband        a sample is only reported once it moved deadband_permille of the last report (or of floor)
+ *   coalescing      log records are held up to coalesce_ms so several reports share one radio frame
+ *
+ * A report is always sent once report_max_ms has passed since the last one, so a quiet sensor is still seen. Records
+ * held by the coalescing carry the time of their frame, so coalesce_ms is also the timestamp error of a report.
+ * Each window ends with two LOG() records of the state, see governor_stats(), and a third if the DCDC was held in low
+ * noise mode for more than POWER_QUIET_MAX_PERMILLE of the window.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t      capacity_uah;     // usable battery charge
+  uint32_t      lifetime_days;    // deployment the battery has to last
+  uint32_t      state_ua[POWER_STATES]; // processor current in each power state
+  uint32_t      base_ua;          // current of everything that is always on
+  uint32_t      sample_nc;        // charge of one sample cycle of the sensor registry
+  uint32_t      frame_nc;         // charge of waking the radio for one frame
+  uint32_t      byte_nc;          // charge of sending one byte
+  uint32_t      window_ms;        // time between adjustments
+  uint32_t      horizon_ms;       // time a reserve or deficit is spread over
+  uint32_t      period_min_ms;    // sample period bounds, equal to keep the period fixed
+  uint32_t      period_max_ms;
+  uint32_t      deadband_min_permille;
+  uint32_t      deadband_max_permille;
+  uint32_t      coalesce_min_ms;
+  uint32_t      coalesce_max_ms;
+  uint32_t      report_max_ms;    // longest a sensor may go without a report
+} GOVERNOR_OPEN_STRUCT;
+
+typedef struct {
+  int32_t       floor;            // sample units, the deadband of values closer to 0 than this is taken from it
+  int32_t       value;            // last value reported
+  uint32_t      timestamp;
+  bool          reported;
+} GOVERNOR_REPORT;
+
+typedef struct {
+  uint32_t      elapsed_s;        // since governor_open()
+  uint32_t      consumed_uah;
+  uint32_t      budget_uah;       // allowed by the trajectory at elapsed_s
+  int32_t       reserve_uah;      // budget_uah - consumed_uah, negative when behind the trajectory
+  uint32_t      window_na;        // average current of the last window
+  uint32_t      target_na;        // current the last window aimed the level at
+  uint32_t      average_na;       // since governor_open()
+  uint32_t      projected_days;   // lifetime of the full capacity at average_na
+  uint32_t      level;
+  uint32_t      period_ms;
+  uint32_t      deadband_permille;
+  uint32_t      coalesce_ms;
+  uint32_t      adjustments;      // windows that moved the level
+  uint32_t      reports;          // samples reported through governor_report_due()
+  uint32_t      suppressed;       // samples held back by the deadband
+  uint32_t      quiet_permille;   // share of the last window the DCDC was held in low noise mode
+  uint32_t      quiet_windows;    // windows over POWER_QUIET_MAX_PERMILLE
+} GOVERNOR_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void governor_open(const GOVERNOR_OPEN_STRUCT *governor_setup);
+bool governor_service(void);
+void governor_sample_cycle(void);
+uint32_t governor_period_ms(void);
+void governor_report_init(GOVERNOR_REPORT *report, int32_t floor);
+bool governor_report_due(GOVERNOR_REPORT *report, const SENSOR_SAMPLE *sample);
+void governor_stats(GOVERNOR_STATS *stats);
+
+#endif
@@ -19,6 +19,8 @@
 // global variables
 //***********************************************************************************
 #define I2C_EM_BLOCK   EM2
+#define I2C_NO_REGISTER  0xFFFFFFFF  // read straight from the device without first writing a register address
+#define I2C_SLAVE_MAP_SIZE  32       // bytes of register map served in slave mode
 
 typedef struct {
   bool                  enable;
@@ -33,6 +35,7 @@ typedef struct {
   bool                  ack_irq_enable;
   bool                  rxdatav_irq_enable;
   bool                  stop_irq_enable;
+  uint32_t              slave_address;  // 7 bit address matched when master is false (I2C0 only)
 
 
 } I2C_OPEN_STRUCT ;
@@ -66,6 +69,18 @@ typedef struct {
 
 } I2C_STATE_MACHINE;
 
+typedef struct {
+  I2C_TypeDef           *i2cx;          // NULL while the peripheral is a master
+  uint8_t               map[2][I2C_SLAVE_MAP_SIZE];  // snapshot served to the host and the one being published
+  volatile uint32_t     front;          // map the ISR reads from
+  volatile bool         pending;        // the other map holds a newer snapshot, swapped at the next transaction
+  bool                  in_transaction; // address matched, no STOP yet
+  bool                  pointer_set;    // first byte of a host write sets the register pointer
+  uint32_t              reg;            // register pointer, increments on every byte read
+  uint32_t              bytes_served;
+  uint32_t              transactions;
+} I2C_SLAVE_STATE;
+
 
 //***********************************************************************************
 // function prototypes
@@ -73,6 +88,9 @@ typedef struct {
 void i2c_start(I2C_TypeDef *i2c, uint32_t device_address, OPERATION_MODE mode, uint32_t *data, uint32_t bytes_expected, uint32_t desired_register_address, uint32_t app_cb);
 void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup);
 bool i2c_available(I2C_TypeDef *i2c);
+void i2c_slave_publish(I2C_TypeDef *i2c, const uint8_t *data, uint32_t length);
+uint32_t i2c_slave_bytes_served(I2C_TypeDef *i2c);
+uint32_t i2c_slave_transactions(I2C_TypeDef *i2c);
 void I2C0_IRQHandler(void);
 void I2C1_IRQHandler(void);
 
@@ -21,7 +21,7 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
-#define LETIMER_HZ    1000       // Utilizing ULFRCO oscillator for LETIMERs
+#define LETIMER_HZ    1000       // Utilizing ULFRCO oscillator for LETIMERs, nominal until letimer_clock_set()
 #define LETIMER_EM    EM4       // Using the ULFRCO, block from entering energey mode 4
 
 //***********************************************************************************
@@ -51,5 +51,16 @@ typedef struct {
 void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_letimer_struct);
 void letimer_start(LETIMER_TypeDef *letimer, bool enable);
 void LETIMER0_IRQHandler(void);
+uint32_t letimer_time_ms(LETIMER_TypeDef *letimer);
+uint32_t letimer_uf_count(LETIMER_TypeDef *letimer);
+void letimer_pwm_active_set(LETIMER_TypeDef *letimer, float active_period);
+void letimer_out_enable(LETIMER_TypeDef *letimer, bool out0_en, bool out1_en);
+void letimer_clock_set(LETIMER_TypeDef *letimer, uint32_t clock_mhz);
+void letimer_period_set(LETIMER_TypeDef *letimer, float period);
+float letimer_period_get(LETIMER_TypeDef *letimer);
+uint32_t letimer_clock_get(LETIMER_TypeDef *letimer);
+void letimer_uf_capture_set(LETIMER_TypeDef *letimer, uint32_t (*capture)(void));
+void letimer_uf_captured(LETIMER_TypeDef *letimer, uint32_t *ticks, uint32_t *ref);
+void letimer_uf_release(LETIMER_TypeDef *letimer, uint32_t *count, uint32_t *time_ms);
 
 #endif
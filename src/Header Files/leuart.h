@@ -5,7 +5,9 @@
 #define LEUART_GUARD_H
 
 #include "em_leuart.h"
+#include "em_ldma.h"
 #include "sleep_routines.h"
+#include "dma.h"
 
 
 //***********************************************************************************
@@ -14,6 +16,7 @@
 
 #define LEUART_TX_EM    3
 #define LEUART_RX_EM    3
+#define LEUART_RX_RING  32    // received bytes held until the rx_done_evt is serviced, power of 2
 
 /***************************************************************************//**
  * @addtogroup leuart
@@ -60,6 +63,8 @@ typedef struct{
   uint32_t              leuart_cb;
   DEFINED_LEUART_STATES state;
   LEUART_TypeDef        *leuart;
+  LDMA_Descriptor_t     tx_desc;      // used by leuart_tx_dma(), read by the LDMA after the call returns
+  uint32_t              dma_ch;       // TX channel from dma_channel_alloc()
 
 } LEUART_STATE_MACHINE;
 
@@ -78,7 +83,10 @@ typedef struct{
 void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings);
 void LEUART0_IRQHandler(void);
 void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len);
+void leuart_tx_dma(LEUART_TypeDef *leuart, const uint8_t *data, uint32_t length, uint32_t tx_cb);
 bool leuart_tx_busy(LEUART_TypeDef *leuart);
+uint32_t leuart_rx_read(LEUART_TypeDef *leuart, uint8_t *data, uint32_t max);
+void leuart_rx_irq_enable(LEUART_TypeDef *leuart, bool enable);
 
 uint32_t leuart_status(LEUART_TypeDef *leuart);
 void leuart_cmd_write(LEUART_TypeDef *leuart, uint32_t cmd_update);
@@ -0,0 +1,89 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef LOG_HG
+#define LOG_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "leuart.h"
+#include "frame.h"
+#include "ram.h"
+#include "letimer.h"
+#include "ble.h"
+#include "brd_config.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LOG_RING_WORDS        (256 + RAM_HEAP_RECLAIMED / 8)  // power of 2, 1 KB of records, 2 KB heap-free
+#define LOG_ARGS_MAX          4
+#define LOG_FRAME_PAYLOAD     240                 // record bytes carried by each frame
+#define LOG_LEUART            HM10_LEUART0
+#define LOG_ID_DROPPED        0xFFFF              // record id carrying the number of records lost to a full ring
+#define LOG_COALESCE_WORDS    (LOG_RING_WORDS / 2) // ring use that sends a held batch before its window is over
+
+/*
+ * Deferred formatting log. Each LOG() site puts its format string in the .log_fmt section, which the linker script
+ * places at address 0 as an INFO section, so it takes no flash and the address of the string is its offset in the
+ * section. That offset is the 16 bit id of the site. A log call only stores the id and the raw 32 bit arguments in a
+ * ring, and log_flush() sends the ring in frame_type_log frames. The text is rebuilt on the host by
+ *   python3 tools/log_decode.py <project>.axf <capture>
+ * which reads the format strings out of the ELF.
+ *
+ * Arguments are 32 bit integers and the format may use %d %i %u %x %X %c with flags and width, and %%.
+ * Strings cannot be passed, put them in the format (one site per string).
+ *
+ *   cost of a call         ~30 cycles: reserve with LDREX/STREX, store the arguments, store the header
+ *   bytes on the wire      2 + 4 per argument, plus a 4 byte time and the 10 byte frame once per flush
+ *   ex. "rule %d on = %d"  10 bytes, against 16 as text plus the sprintf on the device
+ *
+ * Calls are safe from interrupts. A record is only sent once its header is stored, so a record interrupted by another
+ * log call never goes out half written.
+ */
+#define LOG(fmt, ...) do{ \
+    _Static_assert(LOG_NARGS(__VA_ARGS__) <= LOG_ARGS_MAX, "LOG() takes at most 4 arguments"); \
+    static const char log_fmt_site[] __attribute__((section(".log_fmt"), used)) = fmt; \
+    LOG_CALL(LOG_NARGS(__VA_ARGS__))((uint32_t)log_fmt_site, ##__VA_ARGS__); \
+  }while(0)
+
+#define LOG_NARGS(...)                            LOG_NARGS_(_, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_, a1, a2, a3, a4, a5, n, ...) n
+#define LOG_CALL(n)                               LOG_CALL_(n)
+#define LOG_CALL_(n)                              log_write##n
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t      records;          // records sent
+  uint32_t      dropped;          // records lost to a full ring
+  uint32_t      frames;
+  uint32_t      wire_bytes;       // frame bytes sent
+} LOG_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void log_open(uint32_t tx_done_cb);
+void log_write0(uint32_t id);
+void log_write1(uint32_t id, uint32_t a1);
+void log_write2(uint32_t id, uint32_t a1, uint32_t a2);
+void log_write3(uint32_t id, uint32_t a1, uint32_t a2, uint32_t a3);
+void log_write4(uint32_t id, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4);
+void log_flush(void);
+void log_coalesce_set(uint32_t window_ms);
+void log_tx_done_service(void);
+void log_stats(LOG_STATS *stats);
+
+#endif
@@ -0,0 +1,84 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef LTTB_HG
+#define LTTB_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LTTB_HULL_MAX       16          // points kept on each of the upper and lower hull of a bucket
+#define LTTB_SPAN_MAX       0x7FFFFFFF  // ms from the first point, keeps the cross products in 64 bits
+#define LTTB_VALUE_MAX      (1 << 30)
+
+/*
+ * Largest-Triangle-Three-Buckets downsampling in one pass over the input.
+ *
+ * The first and last points are kept and the rest are split into out_points - 2 buckets. From each bucket LTTB keeps
+ * the point that makes the largest triangle with the point kept from the bucket before and the average of the bucket
+ * after. The average of the next bucket is only known once that bucket has been read, but the triangle area is the
+ * absolute value of a linear function of the candidate point, so its maximum is always on the convex hull of the
+ * bucket. Only the upper and lower hulls of a bucket are kept (monotone chain, the input is in time order) while the
+ * next bucket is read, so memory is the output array plus two hulls whatever the bucket size.
+ *
+ * A hull of sensor data is a handful of points. If one reaches LTTB_HULL_MAX its oldest interior point is dropped,
+ * the only case where the result can differ from the classic algorithm.
+ *
+ * Cost per input point: a hull update (amortized ~2 cross products) and two sums. tools/lttb_bench.c measures it on the
+ * host against a reference implementation, LTTB_BENCHMARK_ON_BOOT in app.h measures it on the target.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t      timestamp;        // ms, in increasing order
+  int32_t       value;
+} LTTB_POINT;
+
+typedef struct {
+  LTTB_POINT    upper[LTTB_HULL_MAX];
+  LTTB_POINT    lower[LTTB_HULL_MAX];
+  uint32_t      upper_count;
+  uint32_t      lower_count;
+  int64_t       sum_t;            // relative to the first input point
+  int64_t       sum_v;
+  uint32_t      count;
+} LTTB_BUCKET;
+
+typedef struct {
+  LTTB_POINT    *out;
+  uint32_t      out_points;
+  uint32_t      out_count;
+  uint32_t      in_points;
+  uint32_t      in_count;
+  uint32_t      origin;           // timestamp of the first point
+  uint32_t      last;             // timestamp of the last point pushed
+  LTTB_POINT    selected;         // last point kept
+  LTTB_BUCKET   bucket[2];        // held bucket waiting for the next average, and the bucket being read
+  uint32_t      held;             // index of the held bucket in bucket[]
+  bool          held_valid;
+  uint32_t      current_index;    // bucket number of the bucket being read
+  uint32_t      next_bucket;      // input index where the next bucket starts
+  uint32_t      hull_drops;       // hull points dropped at LTTB_HULL_MAX
+} LTTB_STATE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void lttb_open(LTTB_STATE *lttb, uint32_t in_points, LTTB_POINT *out, uint32_t out_points);
+bool lttb_point_valid(const LTTB_STATE *lttb, const LTTB_POINT *point);
+void lttb_push(LTTB_STATE *lttb, const LTTB_POINT *point);
+uint32_t lttb_close(LTTB_STATE *lttb);
+
+#endif
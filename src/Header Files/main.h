@@ -20,6 +20,7 @@
 #include "app.h"
 #include "brd_config.h"
 #include "scheduler.h"
+#include "ram.h"
 
 //***********************************************************************************
 // defined files
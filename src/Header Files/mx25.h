@@ -0,0 +1,32 @@
+/*
+ * mx25.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: adamv
+ */
+
+#ifndef HEADER_FILES_MX25_H_
+#define HEADER_FILES_MX25_H_
+
+#include "spi.h"
+#include "brd_config.h"
+#include "HW_delay.h"
+
+#define   MX25_CMD_READ             0x03  //read data, up to 33 MHz
+#define   MX25_CMD_DEEP_POWER_DOWN  0xB9
+#define   MX25_CMD_RELEASE_DPD      0xAB  //release from deep power down
+#define   MX25_CMD_BYTES            4     //command + 24 bit address
+#define   MX25_WAKE_DELAY           1     //ms, covers the 35 us release from deep power down
+#define   MX25_SIZE                 0x100000  //MX25R8035F, 8 Mbit
+#define   MX25_BAUDRATE             6500000   //HFPERCLK / 4, see the table in spi.h
+#define   MX25_READS_QUEUED         (SPI_QUEUE_SIZE / 2)  //each read is a command and a data transaction
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void mx25_open(void);
+void mx25_wake(void);
+void mx25_deep_power_down(void);
+bool mx25_read(uint32_t address, uint8_t *data, uint32_t length, uint32_t read_cb);
+
+#endif /* HEADER_FILES_MX25_H_ */
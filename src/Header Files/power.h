@@ -0,0 +1,65 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef POWER_HG
+#define POWER_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_emu.h"
+#include "em_core.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "sleep_routines.h"
+#include "letimer.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define POWER_QUIET_CONDUCTION      emuDcdcConductionMode_ContinuousLN      // fixed frequency, lowest ripple
+#define POWER_EFFICIENT_CONDUCTION  emuDcdcConductionMode_DiscontinuousLN   // pulse skipping, lower loss at light load
+#define POWER_QUIET_MAX             8       // outstanding quiet requests before it is treated as a leak
+#define POWER_QUIET_MAX_PERMILLE    10      // share of the time the supply may be held quiet, more means a request is held too long
+
+/*
+ * The DCDC always runs in low power mode in EM2/EM3, the policy only chooses how it regulates in EM0/EM1.
+ * The time spent in each state is kept in POWER_STATS.state_ms, so the average current saved over a day is
+ *   (state_ms[power_state_efficient] * (I_ccm - I_dcm)) / total ms
+ * with I_ccm and I_dcm measured once on the bench at the EM0 load of this firmware.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  power_state_efficient,          // EM0/EM1, DCDC in POWER_EFFICIENT_CONDUCTION
+  power_state_quiet,              // EM0/EM1, DCDC in POWER_QUIET_CONDUCTION for an analog measurement
+  power_state_em23,               // EM2/EM3, DCDC in low power mode
+  POWER_STATES
+}
+POWER_STATE;
+
+typedef struct {
+  uint32_t      quiet_entries;    // efficient -> quiet transitions
+  uint32_t      em23_entries;     // EM0/EM1 -> EM2/EM3 transitions
+  uint32_t      state_ms[POWER_STATES];
+} POWER_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void power_open(void);
+void power_quiet_request(void);
+void power_quiet_release(void);
+void power_sleep_enter(uint32_t EM);
+void power_sleep_exit(uint32_t EM);
+void power_stats(POWER_STATS *stats);
+
+#endif
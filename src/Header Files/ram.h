@@ -0,0 +1,49 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef RAM_HG
+#define RAM_HG
+
+/* System include statements */
+#include <stdint.h>
+
+/* Silicon Labs include statements */
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_assert.h"
+#include "sl_memory_config.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+// Place large buffers with one of these so the linker packs them below __ram_used_end__
+#define RAM_RETAINED    __attribute__((section(".ram_retained")))   // zeroed at boot, kept through EM2/EM3
+#define RAM_NORETAIN    __attribute__((section(".ram_noretain")))   // not cleared at boot, rebuilt before each use
+
+// RAM the heap held before SL_HEAP_FREE, buffers that grow by a share of it keep the RAM used the same
+#if SL_HEAP_FREE
+#define RAM_HEAP_RECLAIMED  2048
+#else
+#define RAM_HEAP_RECLAIMED  0
+#endif
+
+/*
+ * Bank usage is reported after every build by
+ *   python3 tools/ram_bank_report.py <project>.axf
+ * which lists the bytes used in each RAM block and the blocks ram_open() powers down.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void ram_open(void);
+uint32_t ram_used_bytes(void);
+
+#endif
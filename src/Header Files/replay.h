@@ -0,0 +1,91 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef REPLAY_HG
+#define REPLAY_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "mx25.h"
+#include "leuart.h"
+#include "frame.h"
+#include "lttb.h"
+#include "ram.h"
+#include "letimer.h"
+#include "ble.h"
+#include "scheduler.h"
+#include "brd_config.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define REPLAY_PAYLOAD_SIZE   240                 // flash bytes carried by each frame
+#define REPLAY_BUFFERS        2                   // one fills from the flash while the other drains to the LEUART
+#define REPLAY_LEUART         HM10_LEUART0
+#define REPLAY_LINK_BAUD      HM10_BAUDRATE
+#define REPLAY_BITS_PER_BYTE  10                  // start + 8 data + stop
+#define REPLAY_POINT_SIZE     8                   // history record in the flash, {uint32 ms, int32 value} little endian
+#define REPLAY_ERASED         0xFFFFFFFF          // timestamp of a record slot that was never written
+#define REPLAY_LTTB_OUT_MAX   (512 + RAM_HEAP_RECLAIMED / 16)  // most points a history query returns, half the heap
+
+/*
+ * Expected throughput, 9600 baud LEUART, 6.5 Mbps SPI:
+ *   link capacity                        960 B/s
+ *   frame on the wire                    250 B, 240 B payload (96.0% goodput)
+ *   flash read of one payload            ~0.3 ms, hidden behind the ~260 ms drain of the other buffer
+ *   gap between frames                   TXC interrupt + scheduler latency, tens of us per 260 ms frame
+ * so the link stays above 99.9% busy and the payload rate is ~920 B/s. replay_stats() reports what was measured.
+ *
+ * At ~920 B/s a day of 1 s history records (86400 points, 691 kB) takes 12.5 minutes to send. replay_start_lttb()
+ * reads the records through the same flash pipeline at the SPI rate, downsamples them with LTTB while the next payload
+ * is read, and sends only the kept points: 500 points is 4 kB, under 5 s on the link, and the spikes and edges that
+ * plain decimation would skip are kept.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  replay_buf_empty,
+  replay_buf_filling,             // LDMA is reading the flash into the payload
+  replay_buf_full,                // framed, waiting for the LEUART
+  replay_buf_draining             // LDMA is feeding the LEUART
+}
+REPLAY_BUF_STATE;
+
+typedef struct {
+  uint32_t      frames;
+  uint32_t      payload_bytes;
+  uint32_t      wire_bytes;       // payload plus framing
+  uint32_t      elapsed_ms;       // replay_start() to the end of the last frame
+  uint32_t      link_permille;    // wire bytes / link capacity over elapsed_ms
+  uint32_t      goodput_permille; // payload bytes / link capacity over elapsed_ms
+  uint32_t      points_in;        // history records read by a downsampled query
+  uint32_t      points_out;       // points sent by a downsampled query
+  uint32_t      downsample_ms;    // replay_start_lttb() to the first frame
+  uint32_t      read_retries;     // flash reads put off because the SPI queue was full
+  bool          history_error;    // record points_in was erased or out of order, the query ended without sending
+} REPLAY_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void replay_open(uint32_t fill_cb, uint32_t drain_cb, uint32_t done_cb);
+bool replay_start(uint32_t address, uint32_t length);
+bool replay_start_lttb(uint32_t address, uint32_t points, uint32_t out_points);
+bool replay_active(void);
+void replay_fill_service(void);
+void replay_drain_service(void);
+void replay_poll(void);
+void replay_stats(REPLAY_STATS *stats);
+
+#endif
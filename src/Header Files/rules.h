@@ -0,0 +1,81 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef RULES_HG
+#define RULES_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "sensor.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define RULES_MAX           16    // rules the engine keeps state for
+#define RULES_STACK_DEPTH   8     // evaluation stack of a single rule
+#define RULES_DAY_MIN       1440
+#define RULES_RATE_BASE_MS  60000 // shortest time base of a rate, keeps sensor noise from reading as a fast change
+#define RULES_RATE_STEP_MS  15000 // spacing of the samples kept per sensor as rate bases
+#define RULES_RATE_POINTS   (RULES_RATE_BASE_MS / RULES_RATE_STEP_MS + 1)
+
+/*
+ * Rule record, compiled by tools/gen_rules.py from tools/rules.cfg into rules_config.c:
+ *
+ *   offset  size  field
+ *   0       1     record length in bytes, a 0 length ends the table
+ *   1       1     rule id, reported in every transition
+ *   2       1     sensor id the rule is evaluated on
+ *   3       2     hold time in seconds, little endian. The condition must stay true this long before the rule goes active
+ *   5       ...   condition, postfix opcodes below. Leaves one value on the stack, non zero is true
+ *
+ * All values are int32 in the unit of the sensor (ex. 0.01 C), rate is in sensor units per minute.
+ *
+ * A rate between two consecutive samples turns one LSB of noise into 30/min at the 2 s period and 240/min at the
+ * 0.25 s capture rate. Rate is taken instead against the newest kept sample at least RULES_RATE_BASE_MS old, with
+ * samples kept every RULES_RATE_STEP_MS, so the base is 60 s to 75 s (or the sample period past 60 s if it is longer)
+ * and one LSB reads as under 1/min. Until a sensor has a sample that old its rate is 0.
+ */
+#define RULE_HEADER_SIZE    5
+
+#define RULE_OP_VALUE       0x01  // push the sample value
+#define RULE_OP_RATE        0x02  // push the change over at least RULES_RATE_BASE_MS, per minute
+#define RULE_OP_CONST       0x03  // push the int32 that follows, little endian
+#define RULE_OP_LT          0x04  // pop b, pop a, push a < b
+#define RULE_OP_GT          0x05
+#define RULE_OP_LE          0x06
+#define RULE_OP_GE          0x07
+#define RULE_OP_AND         0x08
+#define RULE_OP_OR          0x09
+#define RULE_OP_NOT         0x0A  // pop a, push !a
+#define RULE_OP_WINDOW      0x0B  // push 1 if the time of day is in [start, end) minutes, two uint16 follow, wraps past midnight
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint8_t       rule_id;
+  bool          active;           // true when the rule fired, false when it cleared
+  int32_t       value;            // sample that caused the transition
+  uint32_t      timestamp;
+} RULE_TRANSITION;
+
+extern const uint8_t rules_bytecode[];
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void rules_open(const uint8_t *bytecode);
+uint32_t rules_evaluate(const SENSOR_SAMPLE *sample, RULE_TRANSITION *transitions, uint32_t max);
+void rules_time_of_day_set(uint32_t minute, uint32_t now_ms);
+bool rules_active(uint8_t rule_id);
+
+#endif
@@ -20,6 +20,7 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define   NULL_CB           0x00         //no event is scheduled on completion
 
 
 //***********************************************************************************
@@ -0,0 +1,85 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef SENSOR_HG
+#define SENSOR_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "scheduler.h"
+#include "letimer.h"
+#include "power.h"
+#include "HW_delay.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define SENSOR_MAX          8     // Max number of drivers the registry can hold
+
+/*
+ * Consumers that want a reading on demand go through sensor_read() instead of starting their own conversion. A reading
+ * that is new enough is returned from the cache. Otherwise the caller waits for the collect of the conversion that the
+ * sample cycle already has in progress, and every caller waiting on the same sensor is released by that one collect.
+ * Without the cache each such read would cost a trigger write and a result read on the I2C bus.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef enum {
+  sensor_unit_counts,             // raw ADC counts
+  sensor_unit_centi_celsius,      // 0.01 degrees C
+  sensor_unit_centi_percent_rh    // 0.01 %RH
+}
+SENSOR_UNIT;
+
+typedef struct {
+  uint32_t      sensor_id;
+  SENSOR_UNIT   unit;
+  int32_t       value;
+  uint32_t      timestamp;        // ms (letimer_time_ms()) when the conversion was triggered
+} SENSOR_SAMPLE;
+
+// Driver ops table, every sensor driver exports one of these to be placed in the registry
+typedef struct {
+  uint32_t      sensor_id;
+  SENSOR_UNIT   unit;
+  void          (*open)(void);                  // one time setup, may be NULL
+  void          (*trigger)(void);               // start a conversion, may be NULL if another entry starts it
+  void          (*collect)(uint32_t collect_cb); // start the read of the result, collect_cb is scheduled on completion
+  int32_t       (*result)(void);                // converts the collected data to the sample unit
+  void          (*power_down)(void);            // may be NULL if the device idles on its own
+  uint32_t      quiet_ms;                       // DCDC held in low noise mode this long from the trigger, 0 for none
+} SENSOR_OPS;
+
+typedef struct {
+  uint32_t      requests;         // sensor_read() calls
+  uint32_t      hits;             // served from the cache
+  uint32_t      waiters;          // misses released by a collect the sample cycle was doing anyway
+  uint32_t      shared_collects;  // collects that released more than one waiter
+  uint32_t      triggers;         // conversions started for a miss because the sample cycle was idle
+  uint32_t      saved;            // i2c transactions of requests that shared a sample with an earlier request
+  uint32_t      hit_permille;
+} SENSOR_CACHE_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void sensor_open(const SENSOR_OPS *const *registry, uint32_t count, uint32_t collect_cb);
+void sensor_sample_all(void);
+bool sensor_collect_service(SENSOR_SAMPLE *sample);
+void sensor_power_down_all(void);
+bool sensor_read(uint32_t sensor_id, uint32_t max_age_ms, uint32_t ready_cb, SENSOR_SAMPLE *sample);
+bool sensor_cached(uint32_t sensor_id, SENSOR_SAMPLE *sample);
+void sensor_cache_stats(SENSOR_CACHE_STATS *stats);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * spi.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: adamv
+ */
+
+#ifndef SPI_HG
+#define SPI_HG
+
+/* Silicon Labs include statements */
+#include "em_usart.h"
+#include "em_ldma.h"
+#include "em_gpio.h"
+#include "em_cmu.h"
+#include <stdbool.h>
+#include "sleep_routines.h"
+#include "scheduler.h"
+#include "dma.h"
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+#define SPI_EM_BLOCK      EM2    // USART runs from HFPERCLK, stay in EM1 while the RX channel is active
+#define SPI_QUEUE_SIZE    8      // transactions that can be waiting on a single USART
+#define SPI_LDMA_MAX_XFER DMA_MAX_XFER   // bytes moved by one chunk, a single LDMA descriptor
+#define SPI_DUMMY_BYTE    0xFF   // clocked out when a transaction has no tx data
+
+/*
+ * Bit rate = HFPERCLK / (2 * (1 + CLKDIV / 256)), HFPERCLK = 26 MHz (HFRCO band set in main.c)
+ * With LDMA feeding the double buffered TX and draining RX there are no gaps between bytes, so the
+ * sustained byte rate is the bit rate / 8 less a few us of CS/descriptor setup per transaction.
+ *
+ *   divider (1 + CLKDIV/256)   bit rate      byte rate
+ *   1                          13.0 Mbps     1625 kB/s
+ *   2                          6.5 Mbps      812 kB/s
+ *   3                          4.33 Mbps     541 kB/s
+ *   4                          3.25 Mbps     406 kB/s
+ *   8                          1.63 Mbps     203 kB/s
+ *   13                         1.0 Mbps      125 kB/s
+ *   26                         500 kbps      62 kB/s
+ *
+ * spi_bytes_transferred() / spi_transactions_completed() give the measured totals on target.
+ */
+
+typedef struct {
+  bool                    enable;
+  uint32_t                refFreq;
+  uint32_t                baudrate;
+  USART_ClockMode_TypeDef clockMode;
+  bool                    msbf;
+  uint32_t                tx_route;       // ROUTELOC0 TX (MOSI) location
+  uint32_t                rx_route;       // ROUTELOC0 RX (MISO) location
+  uint32_t                clk_route;      // ROUTELOC1 CLK location
+  bool                    tx_pin_en;
+  bool                    rx_pin_en;
+  bool                    clk_pin_en;
+} SPI_OPEN_STRUCT;
+
+typedef struct {
+  GPIO_Port_TypeDef       cs_port;        // chip select, driven low for the transaction
+  uint32_t                cs_pin;
+  const uint8_t           *tx_data;       // NULL clocks out SPI_DUMMY_BYTE
+  uint8_t                 *rx_data;       // NULL discards the received bytes
+  uint32_t                length;
+  bool                    hold_cs;        // leave CS low so the next queued transaction continues the frame
+  uint32_t                spi_cb;         // event scheduled on completion
+} SPI_TRANSACTION;
+
+typedef struct {
+  USART_TypeDef           *usart;
+  bool                    available;      // no transaction in progress
+  uint32_t                ldma_tx_ch;     // from dma_channel_alloc(), feeds TXDATA
+  uint32_t                ldma_rx_ch;     // from dma_channel_alloc(), drains RXDATA
+  LDMA_PeripheralSignal_t tx_signal;
+  LDMA_PeripheralSignal_t rx_signal;
+  LDMA_Descriptor_t       tx_desc;
+  LDMA_Descriptor_t       rx_desc;
+  SPI_TRANSACTION         queue[SPI_QUEUE_SIZE];
+  uint32_t                head;
+  uint32_t                count;
+  uint32_t                offset;         // bytes of the head transaction already moved
+  uint32_t                chunk;          // bytes moved by the LDMA transfer in progress
+  uint8_t                 dummy;
+  uint32_t                bytes;
+  uint32_t                transactions;
+} SPI_STATE_MACHINE;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void spi_open(USART_TypeDef *usart, SPI_OPEN_STRUCT *spi_setup);
+bool spi_queue(USART_TypeDef *usart, const SPI_TRANSACTION *transaction);
+bool spi_available(USART_TypeDef *usart);
+uint32_t spi_queue_space(USART_TypeDef *usart);
+uint32_t spi_bytes_transferred(USART_TypeDef *usart);
+uint32_t spi_transactions_completed(USART_TypeDef *usart);
+
+
+#endif /* SPI_HG */
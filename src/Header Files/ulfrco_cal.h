@@ -0,0 +1,72 @@
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#ifndef ULFRCO_CAL_HG
+#define ULFRCO_CAL_HG
+
+/* System include statements */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Silicon Labs include statements */
+#include "em_cmu.h"
+#include "em_cryotimer.h"
+#include "em_assert.h"
+
+/* The developer's include statements */
+#include "letimer.h"
+#include "sleep_routines.h"
+
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define ULFRCO_CAL_REF_HZ           32768     // LFXO, clocks the CRYOTIMER used as the reference count
+#define ULFRCO_CAL_WINDOW_TICKS     30000     // ULFRCO ticks per measurement, ~30 s (15 periods of 2 s)
+#define ULFRCO_CAL_MIN_MHZ          750000    // first measurement must be inside the ULFRCO range of the datasheet
+#define ULFRCO_CAL_MAX_MHZ          1250000
+#define ULFRCO_CAL_MAX_STEP_PPM     20000     // later measurements further than this from the last one are dropped
+#define ULFRCO_CAL_EM               EM3       // LFXO stops in EM3, the reference must keep counting
+
+/*
+ * The ULFRCO is specified to several percent and drifts with temperature, so LETIMER_HZ alone can be off by tens of
+ * seconds an hour. The LFXO that already clocks the LEUART is accurate to the crystal (~50 ppm). The CMU calibration
+ * counters cannot count the ULFRCO on this part, so the LFXO is counted by the CRYOTIMER instead and read in the
+ * LETIMER0 underflow interrupt:
+ *
+ *   f_ulfrco = ULFRCO ticks in the window * ULFRCO_CAL_REF_HZ / CRYOTIMER counts in the window
+ *
+ * The result is handed to letimer_clock_set() at the end of every window, so the calibration interval is
+ * ULFRCO_CAL_WINDOW_TICKS (~30 s). Error budget for one window:
+ *   - quantization of the reference count       1 / (30 s * 32768)            ~1 ppm
+ *   - interrupt latency jitter at both ends      ~2 us / 30 s                  <0.1 ppm
+ *   - LFXO crystal tolerance                                                   ~50 ppm
+ * The residual timing error is the drift of the ULFRCO from one window to the next, which is the step between two
+ * measurements (ULFRCO_CAL_STATS.last_step_ppm). At a steady temperature this stays within a few ppm, compared with
+ * the percent level error of the nominal LETIMER_HZ. The cost is one register read per underflow and a division per
+ * window, the CRYOTIMER adds well under 100 nA.
+ */
+
+
+//***********************************************************************************
+// global variables
+//***********************************************************************************
+typedef struct {
+  uint32_t      clock_mhz;        // ULFRCO frequency in use, mHz
+  uint32_t      calibrations;     // windows applied to the LETIMER
+  uint32_t      rejected;         // windows dropped by the range checks
+  int32_t       last_step_ppm;    // change made by the last window, the residual error of the one before
+  uint32_t      max_step_ppm;     // largest |last_step_ppm| after the first calibration
+  uint32_t      initial_ppm;      // |error| of the nominal LETIMER_HZ found by the first calibration
+  uint32_t      interval_ms;      // length of the last window
+} ULFRCO_CAL_STATS;
+
+
+//***********************************************************************************
+// function prototypes
+//***********************************************************************************
+void ulfrco_cal_open(void);
+void ulfrco_cal_service(void);
+void ulfrco_cal_stats(ULFRCO_CAL_STATS *stats);
+
+#endif
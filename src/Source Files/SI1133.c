@@ -21,6 +21,22 @@
 static uint32_t si1133_read_data;
 static uint32_t si1133_write_data;
 
+//***********************************************************************************
+// Global variables
+//***********************************************************************************
+static int32_t si1133_sample_result(void);
+
+const SENSOR_OPS si1133_sensor_ops = {
+  .sensor_id  = SI1133_SENSOR_ID,
+  .unit       = sensor_unit_counts,
+  .open       = Si1133_i2c_open,
+  .trigger    = si1133_force_cmd,
+  .collect    = si1133_read_white_light,
+  .result     = si1133_sample_result,
+  .power_down = si1133_power_down,
+  .quiet_ms   = SI1133_QUIET_MS
+};
+
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
@@ -81,6 +97,18 @@ static void si1133_configure(){
 
 }
 
+/***************************************************************************//**
+ * @brief
+ * Returns the last white light reading as a sensor sample value
+ *
+ * @note
+ * This function is the result entry of the si1133 sensor ops table.
+ *
+ ******************************************************************************/
+static int32_t si1133_sample_result(void){
+  return (int32_t)si1133_read_data;
+}
+
 
 //***********************************************************************************
 // Global functions
@@ -198,7 +226,7 @@ uint32_t si1133_read_result(){
  * This function sends the FORCE command to the si1133 CMD register
  *
  * @note
- * This function will be called within the app.c timer comp1 callback function to be automatically called every period of the PWM
+ * This function is the trigger entry of the si1133 sensor ops table and is called by the sensor module every period of the PWM
  *
  ******************************************************************************/
 void si1133_force_cmd(){
@@ -228,7 +256,7 @@ void si1133_force_cmd(){
  * This function begins reading at the HOSTOUT0 register for the first byte of data and will then read from HOST1, and so on, for subsequent data bytes
  *
  * @note
- * This function will be called within the callback function within app.c during the timer UF callback to ensure the si1133 has been properly configured and started
+ * This function is the collect entry of the si1133 sensor ops table, called one period after the FORCE command so the conversion is complete
  *
  * @param light_cb
  * Sets the callback function that will be serviced after a successful white light read operation
@@ -238,5 +266,18 @@ void si1133_read_white_light(uint32_t light_cb){
   si1133_read(2, HOSTOUT0, light_cb);
 }
 
-
-
+/***************************************************************************//**
+ * @brief
+ * This function puts the si1133 into its paused state
+ *
+ * @details
+ * This function sends the PAUSE command to the si1133 CMD register so no autonomous measurements run
+ *
+ * @note
+ * This function is the power down entry of the si1133 sensor ops table
+ *
+ ******************************************************************************/
+void si1133_power_down(){
+  si1133_write_data = PAUSE;
+  si1133_write(1,COMMAND,NULL_CB);
+}
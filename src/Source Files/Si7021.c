@@ -0,0 +1,137 @@
+/**
+ * @file
+ * Si7021.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * This module reads relative humidity and temperature from the si7021 over i2c
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "Si7021.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t si7021_rh_data;
+static uint32_t si7021_temp_data;
+static uint32_t si7021_write_data;
+
+//***********************************************************************************
+// Global variables
+//***********************************************************************************
+// Humidity and temperature are both measured by the single RH trigger, so the temperature entry has no trigger
+const SENSOR_OPS si7021_rh_sensor_ops = {
+  .sensor_id  = SI7021_RH_SENSOR_ID,
+  .unit       = sensor_unit_centi_percent_rh,
+  .open       = si7021_open,
+  .trigger    = si7021_measure_rh,
+  .collect    = si7021_read_rh,
+  .result     = si7021_rh_result,
+  .power_down = NULL
+};
+
+const SENSOR_OPS si7021_temp_sensor_ops = {
+  .sensor_id  = SI7021_TEMP_SENSOR_ID,
+  .unit       = sensor_unit_centi_celsius,
+  .open       = NULL,
+  .trigger    = NULL,
+  .collect    = si7021_read_temp,
+  .result     = si7021_temp_result,
+  .power_down = NULL
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * This function resets the si7021
+ *
+ * @details
+ * This function sends the reset command and waits for the si7021 to power back up. The si7021 shares the I2C1 bus with the
+ * si1133, so the bus must already be opened by Si1133_i2c_open().
+ *
+ * @note
+ * This function is the open entry of the si7021 sensor ops table and is called by sensor_open().
+ *
+ ******************************************************************************/
+void si7021_open(void){
+  i2c_start(I2C1, SI7021_ADDRESS, write, &si7021_write_data, 0, SI7021_RESET, NULL_CB);
+  while(!i2c_available(I2C1)); //wait until end of i2c write
+  timer_delay(SI7021_RESET_DELAY);
+}
+
+/***************************************************************************//**
+ * @brief
+ * This function starts a humidity measurement on the si7021
+ *
+ * @details
+ * Uses the no hold master command so the bus is released during the conversion. The si7021 also measures temperature
+ * as part of every humidity measurement.
+ *
+ * @note
+ * This function is the trigger entry of the si7021 humidity sensor ops table
+ *
+ ******************************************************************************/
+void si7021_measure_rh(void){
+  i2c_start(I2C1, SI7021_ADDRESS, write, &si7021_write_data, 0, SI7021_MEASURE_RH, NULL_CB);
+}
+
+/***************************************************************************//**
+ * @brief
+ * This function reads the result of the last humidity measurement
+ *
+ * @details
+ * In no hold master mode the result is read directly from the device without a register write
+ *
+ * @param[in] rh_cb
+ * Sets the callback function that will be serviced after a successful read operation
+ *
+ ******************************************************************************/
+void si7021_read_rh(uint32_t rh_cb){
+  i2c_start(I2C1, SI7021_ADDRESS, read, &si7021_rh_data, SI7021_RH_BYTES, I2C_NO_REGISTER, rh_cb);
+}
+
+/***************************************************************************//**
+ * @brief
+ * This function reads the temperature measured during the last humidity measurement
+ *
+ * @param[in] temp_cb
+ * Sets the callback function that will be serviced after a successful read operation
+ *
+ ******************************************************************************/
+void si7021_read_temp(uint32_t temp_cb){
+  i2c_start(I2C1, SI7021_ADDRESS, read, &si7021_temp_data, SI7021_TEMP_BYTES, SI7021_READ_PREV_TEMP, temp_cb);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Converts the last humidity reading to hundredths of a percent
+ *
+ * @details
+ * RH = 125 * code / 65536 - 6, from the si7021 datasheet
+ *
+ ******************************************************************************/
+int32_t si7021_rh_result(void){
+  int32_t code = si7021_rh_data & 0xFFFF;
+  return ((12500 * code) >> 16) - 600;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Converts the last temperature reading to hundredths of a degree C
+ *
+ * @details
+ * Temp = 175.72 * code / 65536 - 46.85, from the si7021 datasheet
+ *
+ ******************************************************************************/
+int32_t si7021_temp_result(void){
+  int32_t code = si7021_temp_data & 0xFFFF;
+  return ((17572 * code) >> 16) - 4685;
+}
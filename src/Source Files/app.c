@@ -27,8 +27,30 @@
 //***********************************************************************************
 //#define BLE_TEST_ENABLED
 static int RGB_COLOR;
-static uint32_t x=3;
-static uint32_t y=0;
+static INDICATION_MODE indication_mode;
+static uint8_t host_regs[HOST_REG_SIZE];
+static uint32_t host_samples;
+static DETECT_STATE light_detect;
+static uint32_t cache_report_ms;
+
+// Sensor readings each consumer takes through the cache once per period
+static APP_SENSOR_READ sensor_reads[] = {
+  {app_consumer_alerts, SI1133_SENSOR_ID},
+  {app_consumer_alerts, SI7021_RH_SENSOR_ID},
+  {app_consumer_alerts, SI7021_TEMP_SENSOR_ID},
+  {app_consumer_led, SI1133_SENSOR_ID},
+  {app_consumer_host, SI1133_SENSOR_ID},
+  {app_consumer_host, SI7021_RH_SENSOR_ID},
+  {app_consumer_host, SI7021_TEMP_SENSOR_ID}
+};
+#define   APP_SENSOR_READS    (sizeof(sensor_reads) / sizeof(sensor_reads[0]))
+
+// Sensors sampled every LETIMER0 period, si1133 first since it opens the I2C1 bus the si7021 shares
+static const SENSOR_OPS *const sensor_registry[] = {
+  &si1133_sensor_ops,
+  &si7021_rh_sensor_ops,
+  &si7021_temp_sensor_ops
+};
 
 
 //***********************************************************************************
@@ -36,6 +58,22 @@ static uint32_t y=0;
 //***********************************************************************************
 
 static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, uint32_t out1_route, uint32_t comp0_cb, uint32_t comp1_cb, uint32_t underflow_cb);
+static uint32_t app_consumer_max_age(APP_CONSUMER consumer, uint32_t period_ms);
+static void app_sensor_take(APP_SENSOR_READ *read, SENSOR_SAMPLE *sample);
+static void app_light_sample(SENSOR_SAMPLE *sample);
+static void app_cache_report(void);
+static void app_rules_sample(SENSOR_SAMPLE *sample);
+static void app_host_i2c_open(void);
+static void app_host_publish(SENSOR_SAMPLE *sample);
+static void app_detect_open(void);
+static void app_detect_sample(SENSOR_SAMPLE *sample);
+static void app_governor_open(void);
+static void app_period_apply(void);
+static void app_dma_report(void);
+static void app_cyclic_report(uint32_t tick);
+#ifdef LTTB_BENCHMARK_ON_BOOT
+static void app_lttb_benchmark(void);
+#endif
 
 //***********************************************************************************
 // Global functions
@@ -47,8 +85,9 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
  *
  * @details
  * This function calls our drivers for the CMU, GPIO and letimer, in order to initialize each peripheral.
- * Additionally, this function will initialize our event scheduler and sleep driver.
- * It sets up LETIMER0 with a specified PWM, then starts the timer.
+ * Additionally, this function will initialize our event scheduler, sleep driver and the sensor registry.
+ * It sets up LETIMER0 with a specified PWM, then starts the timer. With CYCLIC_EXECUTIVE_ENABLED the LETIMER0 period is
+ * the minor frame and every underflow releases a frame of the cyclic executive instead of the underflow callback.
  *
  * @note
  * This function will be called in main.c in order to set everything up for operation before we start operation.
@@ -58,13 +97,30 @@ static void app_letimer_pwm_open(float period, float act_period, uint32_t out0_r
 void app_peripheral_setup(void){
   cmu_open();
   sleep_open();
+  power_open();
   gpio_open();
-  Si1133_i2c_open();
   scheduler_open();
+  dma_open(); //before the drivers that take LDMA channels (leuart, spi)
+  sensor_open(sensor_registry, sizeof(sensor_registry) / sizeof(sensor_registry[0]), SENSOR_COLLECT_CB);
+  rules_open(rules_bytecode);
+  app_detect_open();
+  app_host_i2c_open();
   rgb_led_open();
   sleep_block_mode(SYSTEM_BLOCK_EM);
-  ble_open(BLE_TX_DONE_CB, NULL_CB); //add callback events
+  ble_open(BLE_TX_DONE_CB, BLE_RX_CB); //add callback events
+  log_open(LOG_TX_DONE_CB);
+  mx25_open();
+  mx25_deep_power_down(); //woken by replay_start()
+  replay_open(REPLAY_FILL_CB, REPLAY_DRAIN_CB, REPLAY_DONE_CB);
+  app_governor_open(); //after the modules whose telemetry it reads
+  ulfrco_cal_open();
+#ifdef CYCLIC_EXECUTIVE_ENABLED
+  cyclic_exec_open();
+  app_letimer_pwm_open(CYCLIC_MINOR_FRAME_MS / 1000.0, PWM_ACT_PER, PWM_ROUTE_0, PWM_ROUTE_1, LETIMER0_COMP0_CB, LETIMER0_COMP1_CB, CYCLIC_FRAME_CB);
+#else
   app_letimer_pwm_open(PWM_PER, PWM_ACT_PER, PWM_ROUTE_0, PWM_ROUTE_1, LETIMER0_COMP0_CB, LETIMER0_COMP1_CB, LETIMER0_UF_CB);
+#endif
+  app_indication_set(INDICATION_DEFAULT);
   add_scheduled_event(BOOT_UP_CB); //tests UART on startup
 }
 
@@ -111,7 +167,7 @@ void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, u
   app_letimer_pwm_struct.active_period = act_period;
   app_letimer_pwm_struct.debugRun = false;
   app_letimer_pwm_struct.enable = false;
-  app_letimer_pwm_struct.out_pin_0_en = false;
+  app_letimer_pwm_struct.out_pin_0_en = false; //outputs are connected by app_indication_set()
   app_letimer_pwm_struct.out_pin_1_en = false;
   app_letimer_pwm_struct.out_pin_route0 = out0_route;
   app_letimer_pwm_struct.out_pin_route1 = out1_route;
@@ -119,7 +175,7 @@ void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, u
   app_letimer_pwm_struct.comp0_cb = comp0_cb;
   app_letimer_pwm_struct.comp0_irq_enable = false;
   app_letimer_pwm_struct.comp1_cb = comp1_cb;
-  app_letimer_pwm_struct.comp1_irq_enable = true;
+  app_letimer_pwm_struct.comp1_irq_enable = false; //sensors are triggered and collected on underflow
   app_letimer_pwm_struct.uf_cb = underflow_cb;
   app_letimer_pwm_struct.uf_irq_enable = true;
 
@@ -130,6 +186,51 @@ void app_letimer_pwm_open(float period, float act_period, uint32_t out0_route, u
 }
 
 
+/***************************************************************************//**
+ * @brief
+ * Selects the pattern shown on the status LEDs by the LETIMER0 PWM outputs
+ *
+ * @details
+ * The LEDs are driven directly by the LETIMER0 outputs, so once a pattern is set it runs in EM2/EM3 without any
+ * interrupts or CPU work. OUT0 drives the green LED and OUT1 the red LED. Both outputs share the same duty cycle,
+ * so only one of them is connected at a time.
+ *
+ * @note
+ * In the light level mode the duty cycle is updated from the si1133 sample handler, which is already awake.
+ *
+ * @param[in] mode
+ * Pattern to show on the status LEDs
+ *
+ ******************************************************************************/
+void app_indication_set(INDICATION_MODE mode){
+  indication_mode = mode;
+
+  switch(mode){
+    case indication_off:
+      letimer_out_enable(LETIMER0, false, false);
+      break;
+    case indication_heartbeat:
+      letimer_pwm_active_set(LETIMER0, PWM_ACT_PER);
+      letimer_out_enable(LETIMER0, true, false);
+      break;
+    case indication_light_level:
+      letimer_pwm_active_set(LETIMER0, 0);
+      letimer_out_enable(LETIMER0, true, false);
+      break;
+    case indication_error_blink:
+      letimer_pwm_active_set(LETIMER0, letimer_period_get(LETIMER0) / 2);
+      letimer_out_enable(LETIMER0, false, true);
+      break;
+    case indication_error_solid:
+      letimer_pwm_active_set(LETIMER0, letimer_period_get(LETIMER0));
+      letimer_out_enable(LETIMER0, false, true);
+      break;
+    default:
+      EFM_ASSERT(false);
+      break;
+  }
+}
+
 /***************************************************************************//**
  * @brief
  *  Initializes LED color and LEDs
@@ -160,10 +261,17 @@ void rgb_led_open(void){
  * This function handles any operation that needs to be completed when LETIMER0 underflow event occurs.
  *
  * @note
- * This function calls for white light ADC data that has been collected
+ * This function collects the sensor conversions started on the previous underflow and then triggers the next ones.
+ * The ULFRCO calibration window is advanced first so a new clock estimate is in place for the timestamps. A radio
+ * profile that is waiting on the module is retried here. The energy governor may change the period at the end of its
+ * window, which takes effect from this underflow.
  *
  ******************************************************************************/
 void scheduled_letimer0_uf_cb (void){
+  ulfrco_cal_service();
+  if(governor_service()){
+      app_period_apply();
+  }
   //EFM_ASSERT(!(get_scheduled_events() & LETIMER0_UF_CB));
 //  if(RGB_COLOR == 0){
 //      leds_enabled(RGB_LED_1, COLOR_RED, false);
@@ -178,16 +286,156 @@ void scheduled_letimer0_uf_cb (void){
 //      RGB_COLOR = 0;
 //  }
 
-  si1133_read_white_light(SI1133_LIGHT_CB);
-  x = x+3;
-  y = y+1;
-  float z = (float) x/y;
+  app_job_sensor_sample();
+  app_job_report();
+  ble_profile_poll();
+  replay_poll();
+  log_flush();
+}
 
-  char data[60];
-  sprintf(data, "z = %.1f\n", z);
-  ble_write(data);
+/***************************************************************************//**
+ * @brief
+ * Periodic job that runs one sample cycle of the sensor registry
+ *
+ * @note
+ * Called every underflow, or from its slot in the cyclic executive frame table
+ *
+ ******************************************************************************/
+void app_job_sensor_sample(void){
+  governor_sample_cycle();
+  sensor_sample_all();
+}
 
+/***************************************************************************//**
+ * @brief
+ * Periodic job that hands the sensor readings to their consumers and transmits what they report
+ *
+ * @details
+ * Every consumer in sensor_reads[] reads its sensors through the sensor cache with its own age limit, so none of them
+ * adds a conversion of its own. A read that misses waits for the collect the sample cycle has in progress and is
+ * completed by scheduled_sensor_read_cb(). A read that is still waiting is not asked again.
+ *
+ * No sensor value is sent on its own, every sensor is reported only through its rule transitions. The cache
+ * telemetry is logged every APP_CACHE_REPORT_MS.
+ *
+ * @note
+ * Called every underflow, or from its slot in the cyclic executive frame table. Its declared worst case includes
+ * waiting for a previous bluetooth transmit to finish.
+ *
+ ******************************************************************************/
+void app_job_report(void){
+  SENSOR_SAMPLE sample;
+  uint32_t period_ms = governor_period_ms();
+
+  for(uint32_t i = 0; i < APP_SENSOR_READS; i++){
+      APP_SENSOR_READ *read = &sensor_reads[i];
+
+      if(read->waiting){
+          continue;
+      }
+      if(sensor_read(read->sensor_id, app_consumer_max_age(read->consumer, period_ms), SENSOR_READ_CB, &sample)){
+          app_sensor_take(read, &sample);
+      }else{
+          read->waiting = true;
+      }
+  }
+  if(letimer_time_ms(LETIMER0) - cache_report_ms >= APP_CACHE_REPORT_MS){
+      cache_report_ms = letimer_time_ms(LETIMER0);
+      app_cache_report();
+  }
+}
 
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when a sensor read that missed the cache can be completed
+ *
+ * @details
+ * The event is shared by every waiting read, so a read whose sensor has not been collected since it took its last
+ * sample keeps waiting for its own collect.
+ *
+ ******************************************************************************/
+void scheduled_sensor_read_cb(void){
+  SENSOR_SAMPLE sample;
+
+  for(uint32_t i = 0; i < APP_SENSOR_READS; i++){
+      APP_SENSOR_READ *read = &sensor_reads[i];
+
+      if(!read->waiting || !sensor_cached(read->sensor_id, &sample)){
+          continue;
+      }
+      if(!read->taken || sample.timestamp != read->timestamp){
+          read->waiting = false;
+          app_sensor_take(read, &sample);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the oldest sample a consumer accepts from the cache
+ ******************************************************************************/
+static uint32_t app_consumer_max_age(APP_CONSUMER consumer, uint32_t period_ms){
+  switch(consumer){
+    case app_consumer_alerts:
+      return APP_ALERT_MAX_AGE_MS(period_ms);
+    case app_consumer_led:
+      return APP_LED_MAX_AGE_MS(period_ms);
+    case app_consumer_host:
+      return APP_HOST_MAX_AGE_MS(period_ms);
+    default:
+      EFM_ASSERT(false);
+      return 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Hands a sample read through the cache to its consumer
+ *
+ * @details
+ * A consumer that reads faster than the sample cycle may be given the sample it already took, that sample is dropped
+ * so the rules and the detector see every sample once.
+ *
+ * @param[in] read
+ * Entry of sensor_reads[] the sample was read for
+ *
+ * @param[in] sample
+ * Sample from the cache
+ *
+ ******************************************************************************/
+static void app_sensor_take(APP_SENSOR_READ *read, SENSOR_SAMPLE *sample){
+  if(read->taken && sample->timestamp == read->timestamp){
+      return;
+  }
+  read->taken = true;
+  read->timestamp = sample->timestamp;
+  switch(read->consumer){
+    case app_consumer_alerts:
+      app_rules_sample(sample);
+      app_detect_sample(sample);
+      break;
+    case app_consumer_led:
+      app_light_sample(sample);
+      break;
+    case app_consumer_host:
+      app_host_publish(sample);
+      break;
+    default:
+      EFM_ASSERT(false);
+      break;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Logs the sensor cache requests, hit rate and the i2c transactions saved
+ ******************************************************************************/
+static void app_cache_report(void){
+  SENSOR_CACHE_STATS stats;
+
+  sensor_cache_stats(&stats);
+  LOG("cache %d reads hit %d.%d%% saved %d\n", stats.requests, stats.hit_permille / 10, stats.hit_permille % 10,
+      stats.saved);
 }
 
 /***************************************************************************//**
@@ -213,7 +461,7 @@ void scheduled_letimer0_comp0_cb (void){
  * This function handles any operation that needs to be completed when LETIMER0 comp1 event occurs.
  *
  * @note
- * This function initiates an i2c read cycle of the si1133 peripheral
+ * Not used, sensor conversions are triggered from the underflow callback
  *
  ******************************************************************************/
 void scheduled_letimer0_comp1_cb (void){
@@ -230,43 +478,321 @@ void scheduled_letimer0_comp1_cb (void){
 //      leds_enabled(RGB_LED_1, COLOR_BLUE,true);
 //  }
 
-  si1133_force_cmd(); //send force command
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called each time a sensor in the registry has been collected
+ *
+ * @details
+ * This function hands the collect to the sensor module, which fills the cache and releases the reads waiting on it.
+ * The consumers take their samples through the cache in app_job_report() and scheduled_sensor_read_cb().
+ *
+ * @note
+ * The sensor module starts the read of the next sensor before returning, so this is called once per sensor every period.
+ *
+ ******************************************************************************/
+void scheduled_sensor_collect_cb(void){
+  SENSOR_SAMPLE sample;
+
+  sensor_collect_service(&sample);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Handles a white light sample from the si1133
+ *
+ * @details
+ * In the light level indication mode the status LED duty cycle is set from the light value. Darkness is an alert rule
+ * (APP_RULE_DARK), so nothing is transmitted here.
+ *
+ * @param[in] sample
+ * White light sample in ADC counts
+ *
+ ******************************************************************************/
+static void app_light_sample(SENSOR_SAMPLE *sample){
+  int int_data = (int) sample->value;
+
+  if(indication_mode == indication_light_level){
+      uint32_t level = (int_data > INDICATION_LIGHT_FULL_SCALE) ? INDICATION_LIGHT_FULL_SCALE : (uint32_t)int_data;
+      letimer_pwm_active_set(LETIMER0, letimer_period_get(LETIMER0) * level / INDICATION_LIGHT_FULL_SCALE);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Opens I2C0 as a slave so a host controller can poll the latest readings
+ *
+ * @details
+ * The host is served from a register map snapshot by the I2C ISR, so the processor stays in EM3 between host
+ * transactions and wakes only on an address match.
+ *
+ ******************************************************************************/
+static void app_host_i2c_open(void){
+  I2C_OPEN_STRUCT host_i2c_open_struct;
+
+  EFM_ASSERT(HOST_REG_SIZE <= I2C_SLAVE_MAP_SIZE);
+
+  host_i2c_open_struct.clhr = i2cClockHLRStandard;
+  host_i2c_open_struct.enable = true;
+  host_i2c_open_struct.freq = I2C_FREQ_FAST_MAX;
+  host_i2c_open_struct.master = false;
+  host_i2c_open_struct.out_scl_en = true;
+  host_i2c_open_struct.out_sda_en = true;
+  host_i2c_open_struct.refFreq = 0;
+  host_i2c_open_struct.scl_out_route0 = I2C_SCL_PC11;
+  host_i2c_open_struct.sda_out_route0 = I2C_SDA_PC10;
+  host_i2c_open_struct.ack_irq_enable = false;     //slave interrupts are set up by i2c_open()
+  host_i2c_open_struct.rxdatav_irq_enable = false;
+  host_i2c_open_struct.stop_irq_enable = false;
+  host_i2c_open_struct.slave_address = HOST_I2C_ADDRESS;
+
+  i2c_open(HOST_I2C, &host_i2c_open_struct);
+
+  host_regs[HOST_REG_VERSION] = HOST_MAP_VERSION;
+  i2c_slave_publish(HOST_I2C, host_regs, HOST_REG_SIZE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes a little endian 32 bit value into the host register map
+ ******************************************************************************/
+static void app_host_reg_set(uint32_t reg, uint32_t value){
+  host_regs[reg] = (uint8_t)value;
+  host_regs[reg + 1] = (uint8_t)(value >> 8);
+  host_regs[reg + 2] = (uint8_t)(value >> 16);
+  host_regs[reg + 3] = (uint8_t)(value >> 24);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Updates the host register map with a sample and publishes it to the I2C slave
+ *
+ * @param[in] sample
+ * Sample read through the sensor cache
+ *
+ ******************************************************************************/
+static void app_host_publish(SENSOR_SAMPLE *sample){
+  switch(sample->sensor_id){
+    case SI1133_SENSOR_ID:
+      app_host_reg_set(HOST_REG_LIGHT, (uint32_t)sample->value);
+      break;
+    case SI7021_RH_SENSOR_ID:
+      app_host_reg_set(HOST_REG_RH, (uint32_t)sample->value);
+      break;
+    case SI7021_TEMP_SENSOR_ID:
+      app_host_reg_set(HOST_REG_TEMP, (uint32_t)sample->value);
+      break;
+    default:
+      break;
+  }
+  host_samples++;
+  host_regs[HOST_REG_STATUS] = (rules_active(APP_RULE_DARK) ? HOST_STATUS_DARK : 0) |
+                               (replay_active() ? HOST_STATUS_REPLAY : 0);
+  app_host_reg_set(HOST_REG_TIMESTAMP, sample->timestamp);
+  app_host_reg_set(HOST_REG_SAMPLES, host_samples);
+  app_host_reg_set(HOST_REG_SERVED, i2c_slave_bytes_served(HOST_I2C));
+  i2c_slave_publish(HOST_I2C, host_regs, HOST_REG_SIZE);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the alert rules on a sample and transmits only the rules that changed state
+ *
+ * @details
+ * The BLUE LED follows the APP_RULE_DARK rule.
+ *
+ * @param[in] sample
+ * Sample read through the sensor cache
+ *
+ ******************************************************************************/
+static void app_rules_sample(SENSOR_SAMPLE *sample){
+  RULE_TRANSITION transitions[APP_RULE_TRANSITIONS];
+  uint32_t count = rules_evaluate(sample, transitions, APP_RULE_TRANSITIONS);
+
+  for(uint32_t i = 0; i < count; i++){
+      if(transitions[i].rule_id == APP_RULE_DARK){
+          leds_enabled(RGB_LED_1, COLOR_BLUE, transitions[i].active);
+      }
+      if(transitions[i].active){
+          LOG("rule %d on = %d\n", transitions[i].rule_id, transitions[i].value);
+      }else{
+          LOG("rule %d off = %d\n", transitions[i].rule_id, transitions[i].value);
+      }
+  }
+}
 
+/***************************************************************************//**
+ * @brief
+ * Sets up the change-point detector on the si1133 white light
+ ******************************************************************************/
+static void app_detect_open(void){
+  DETECT_OPEN_STRUCT detect_open_struct;
+
+  detect_open_struct.sensor_id = SI1133_SENSOR_ID;
+  detect_open_struct.ema_shift = DETECT_LIGHT_SHIFT;
+  detect_open_struct.z_threshold = DETECT_LIGHT_Z;
+  detect_open_struct.min_sigma = DETECT_LIGHT_SIGMA;
+  detect_open_struct.warmup = DETECT_LIGHT_WARMUP;
+  detect_open(&light_detect, &detect_open_struct);
 }
 
 /***************************************************************************//**
  * @brief
- * Call back function that is called once white light read operation is completed for si1133
+ * Runs a sample through the light change-point detector
  *
  * @details
- * This function handles operation that should occur after a successful i2c white light read operation of the si1133.
+ * When the detector fires, the LETIMER0 period drops to DETECT_FAST_PER so the window after the change is sampled at
+ * 8x the rate. Once the window is full the period goes back to the governor's period and the window is reported. Every
+ * sensor in the registry follows the faster rate for the few seconds of the capture, which is the only energy the
+ * detector costs. Captures are not held back by the governor, their charge is counted like any other sampling.
  *
  * @note
- * This function retrieves the value read from the si1133 peripheral and turns on BLUE LED if read value is less than expected value or
- * turns off if value is greater than or equal to expected value. Transmits data values through bluetooth module.
- *
- ******************************************************************************/
-void scheduled_si1133_read_cb(){
-  uint32_t si1133_data = si1133_read_result();
-
-  if(si1133_data < EXPECTED_READ_DATA){
-      leds_enabled(RGB_LED_1, COLOR_BLUE, true);
-      //write to ble
-      char data[60];
-      int int_data = (int) si1133_data;
-      sprintf(data, "It's dark = %d", int_data);
-      ble_write(data);
-  }else{
-      leds_enabled(RGB_LED_1, COLOR_BLUE, false);
-      //write to ble
-      char data[60];
-      int int_data = (int) si1133_data;
-      sprintf(data, "It's light outside = %d", int_data);
-      ble_write(data);
+ * With CYCLIC_EXECUTIVE_ENABLED the period is the minor frame of the frame table and is not changed, the window is
+ * captured at the normal rate.
+ *
+ * @param[in] sample
+ * Sample read through the sensor cache
+ *
+ ******************************************************************************/
+static void app_detect_sample(SENSOR_SAMPLE *sample){
+  switch(detect_sample(&light_detect, sample)){
+    case detect_triggered:
+#ifndef CYCLIC_EXECUTIVE_ENABLED
+      letimer_period_set(LETIMER0, DETECT_FAST_PER);
+#endif
+      break;
+    case detect_done:
+#ifndef CYCLIC_EXECUTIVE_ENABLED
+      letimer_period_set(LETIMER0, governor_period_ms() / 1000.0f);
+#endif
+      detect_report(&light_detect);
+      break;
+    default:
+      break;
   }
+}
 
+/***************************************************************************//**
+ * @brief
+ * Opens the energy budget governor
+ *
+ * @details
+ * The fastest sample period is PWM_PER and the lowest bound of the coalescing is 0, so with charge to spare the
+ * firmware samples and sends as it did before the governor. With CYCLIC_EXECUTIVE_ENABLED the sample rate is set by
+ * the frame table, so both period bounds are PWM_PER and the governor only moves the coalescing.
+ *
+ * No sensor value is reported outside of its rule transitions, so no value goes through governor_report_due() and
+ * both deadband bounds are 0.
+ *
+ ******************************************************************************/
+static void app_governor_open(void){
+  GOVERNOR_OPEN_STRUCT governor_open_struct;
+
+  governor_open_struct.capacity_uah = APP_BATTERY_UAH;
+  governor_open_struct.lifetime_days = APP_LIFETIME_DAYS;
+  governor_open_struct.state_ua[power_state_efficient] = APP_EM0_UA;
+  governor_open_struct.state_ua[power_state_quiet] = APP_EM0_QUIET_UA;
+  governor_open_struct.state_ua[power_state_em23] = APP_EM23_UA;
+  governor_open_struct.base_ua = APP_BASE_UA;
+  governor_open_struct.sample_nc = APP_SAMPLE_NC;
+  governor_open_struct.frame_nc = APP_FRAME_NC;
+  governor_open_struct.byte_nc = APP_BYTE_NC;
+  governor_open_struct.window_ms = APP_GOV_WINDOW_MS;
+  governor_open_struct.horizon_ms = APP_GOV_HORIZON_MS;
+  governor_open_struct.period_min_ms = (uint32_t)(PWM_PER * 1000);
+#ifdef CYCLIC_EXECUTIVE_ENABLED
+  governor_open_struct.period_max_ms = (uint32_t)(PWM_PER * 1000);
+#else
+  governor_open_struct.period_max_ms = APP_PERIOD_MAX_MS;
+#endif
+  governor_open_struct.deadband_min_permille = 0;
+  governor_open_struct.deadband_max_permille = 0;
+  governor_open_struct.coalesce_min_ms = 0;
+  governor_open_struct.coalesce_max_ms = APP_COALESCE_MAX_MS;
+  governor_open_struct.report_max_ms = 0;
+  governor_open(&governor_open_struct);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Moves the LETIMER0 to the sample period the governor chose
+ *
+ * @details
+ * A change point capture keeps the fast period, app_detect_sample() applies the governor's period when it is done.
+ * The error blink is half of the period, so it is set again for the new one.
+ *
+ ******************************************************************************/
+static void app_period_apply(void){
+#ifndef CYCLIC_EXECUTIVE_ENABLED
+  if(!light_detect.capturing){
+      letimer_period_set(LETIMER0, governor_period_ms() / 1000.0f);
+  }
+  if(indication_mode == indication_error_blink){
+      app_indication_set(indication_mode);
+  }
+#endif
 }
 
+#ifdef LTTB_BENCHMARK_ON_BOOT
+/***************************************************************************//**
+ * @brief
+ * Returns synthetic point i of the LTTB benchmark, a light level ramp with noise and a spike every 2000 points
+ ******************************************************************************/
+static LTTB_POINT app_lttb_bench_point(uint32_t i, uint32_t *seed){
+  LTTB_POINT point;
+  uint32_t phase = i % 20000;
+
+  *seed = *seed * 1664525 + 1013904223;
+  point.timestamp = i * 1000;
+  point.value = (int32_t)(phase < 10000 ? phase : 20000 - phase) / 10 + (int32_t)(*seed >> 28);
+  if(i % 2000 == 1000){
+      point.value += 5000;
+  }
+  return point;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Measures LTTB on the target
+ *
+ * @details
+ * Downsamples 10k, 50k and 100k synthetic points to LTTB_BENCH_OUT_POINTS and logs the DWT cycles per input point,
+ * less the cycles spent making the points. Runs once at boot, before the LETIMER is started.
+ *
+ ******************************************************************************/
+static void app_lttb_benchmark(void){
+  static LTTB_POINT out[LTTB_BENCH_OUT_POINTS] RAM_NORETAIN;
+  static const uint32_t sizes[] = {10000, 50000, 100000};
+  LTTB_STATE lttb;
+  LTTB_POINT point;
+  uint32_t seed, start, gen_cycles, cycles;
+  volatile int32_t sink = 0;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+      seed = 1;
+      start = DWT->CYCCNT;
+      for(uint32_t i = 0; i < sizes[s]; i++){
+          sink += app_lttb_bench_point(i, &seed).value;
+      }
+      gen_cycles = DWT->CYCCNT - start;
+
+      seed = 1;
+      start = DWT->CYCCNT;
+      lttb_open(&lttb, sizes[s], out, LTTB_BENCH_OUT_POINTS);
+      for(uint32_t i = 0; i < sizes[s]; i++){
+          point = app_lttb_bench_point(i, &seed);
+          lttb_push(&lttb, &point);
+      }
+      lttb_close(&lttb);
+      cycles = DWT->CYCCNT - start - gen_cycles;
+      LOG("lttb %d pts %d cyc/pt hull drops %d\n", sizes[s], cycles / sizes[s], lttb.hull_drops);
+  }
+}
+#endif
+
 /***************************************************************************//**
  * @brief
  * Call back function that is called on startup of mighty gecko.
@@ -288,7 +814,16 @@ void scheduled_boot_up_cb(){
 #endif
   char data[18] = "This is a test ;)\0";
   ble_write(data);
+#ifdef LTTB_BENCHMARK_ON_BOOT
+  app_lttb_benchmark();
+#endif
   letimer_start(LETIMER0, true);  //This command will initiate the start of the LETIMER0
+  ble_profile_set(BLE_PROFILE_DEFAULT);
+#if defined(HISTORY_LTTB_ON_BOOT)
+  replay_start_lttb(HISTORY_ADDRESS, HISTORY_POINTS, HISTORY_OUT_POINTS);
+#elif defined(LOG_REPLAY_ON_BOOT)
+  replay_start(LOG_REPLAY_ADDRESS, LOG_REPLAY_LENGTH);
+#endif
 }
 
 /***************************************************************************//**
@@ -306,5 +841,118 @@ void scheduled_ble_tx_done_cb(){
   //not used in this lab
 }
 
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when the bluetooth module has sent bytes to the micro-controller
+ ******************************************************************************/
+void scheduled_ble_rx_cb(void){
+  ble_rx_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when the replay has read the next payload from the flash
+ ******************************************************************************/
+void scheduled_replay_fill_cb(void){
+  replay_fill_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when the replay has finished transmitting a frame
+ ******************************************************************************/
+void scheduled_replay_drain_cb(void){
+  replay_drain_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when a replay has finished
+ *
+ * @details
+ * Logs the sustained replay rate as a fraction of the link capacity, and for a downsampled history query how many
+ * records were reduced to how many points and how long the reduction took. A replay keeps the SPI and LEUART channels
+ * busy at once, so the LDMA utilisation is logged after it.
+ *
+ ******************************************************************************/
+void scheduled_replay_done_cb(void){
+  REPLAY_STATS stats;
+
+  replay_stats(&stats);
+  LOG("replay %d B %d ms link %d.%d%%\n", stats.payload_bytes, stats.elapsed_ms, stats.link_permille / 10,
+      stats.link_permille % 10);
+  if(stats.history_error){
+      LOG("history bad record %d, query ended\n", stats.points_in);
+  }else if(stats.points_out){
+      LOG("history %d -> %d points in %d ms\n", stats.points_in, stats.points_out, stats.downsample_ms);
+  }
+  app_dma_report();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Logs the utilisation of every allocated LDMA channel and the time channels were competing
+ ******************************************************************************/
+static void app_dma_report(void){
+  DMA_STATS stats;
+
+  dma_stats(&stats);
+  for(uint32_t ch = 0; ch < DMA_CHANNELS; ch++){
+      if(stats.channel[ch].allocated){
+          LOG("dma ch%d %d xfers %d B util %d permille\n", ch, stats.channel[ch].transfers, stats.channel[ch].bytes,
+              stats.channel[ch].util_permille);
+      }
+  }
+  LOG("dma peak %d active, %d ms concurrent of %d ms\n", stats.peak_active, stats.concurrent_ms, stats.elapsed_ms);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Logs the overrun count of the cyclic executive and the largest release jitter of each job against its declared WCET
+ *
+ * @param[in] tick
+ * Number of the underflow that released the current frame
+ ******************************************************************************/
+static void app_cyclic_report(uint32_t tick){
+  LOG("cyclic %d frames %d overruns\n", tick, cyclic_exec_overruns());
+  for(uint32_t job = 0; job < CYCLIC_JOBS; job++){
+      LOG("cyclic job %d jitter %d ms wcet %d us\n", job, cyclic_exec_max_jitter_ms(job), cyclic_jobs[job].wcet_us);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called when a log frame has been transmitted
+ ******************************************************************************/
+void scheduled_log_tx_done_cb(void){
+  log_tx_done_service();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Call back function that is called on every LETIMER0 underflow with CYCLIC_EXECUTIVE_ENABLED
+ *
+ * @details
+ * Releases the frame of the cyclic executive first to keep the release jitter low, then runs the per period services
+ * that scheduled_letimer0_uf_cb() runs without the cyclic executive. The overruns and job jitter are logged every
+ * APP_CYCLIC_REPORT_MS.
+ *
+ ******************************************************************************/
+void scheduled_cyclic_frame_cb(void){
+  uint32_t tick;
+  uint32_t release_ms;
+
+  letimer_uf_release(LETIMER0, &tick, &release_ms);
+  cyclic_exec_frame(tick, release_ms);
+  if(tick % (APP_CYCLIC_REPORT_MS / CYCLIC_MINOR_FRAME_MS) == 0){
+      app_cyclic_report(tick);
+  }
+  ulfrco_cal_service();
+  governor_service(); //the period bounds are equal, only the coalescing moves
+  ble_profile_poll();
+  replay_poll();
+  log_flush();
+}
+
 
 
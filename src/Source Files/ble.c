@@ -17,11 +17,78 @@
 //***********************************************************************************
 // defined files
 //***********************************************************************************
+#define BLE_CODE_UNKNOWN      0xFF      // module value not known, always sent
+#define BLE_CMD_NONE          -1
+#define BLE_CMD_RESET         ble_param_count
+#define BLE_AT_RETRY_MS       30000     // retry interval while a connection is only assumed from a timeout
 
 
 //***********************************************************************************
 // private variables
 //***********************************************************************************
+static const char *const ble_param_cmd[ble_param_count] = {
+  [ble_param_notify] = "AT+NOTI",
+  [ble_param_adv_interval] = "AT+ADVI",
+  [ble_param_tx_power] = "AT+POWE",
+#ifdef BLE_CONN_PARAMS_SUPPORTED
+  [ble_param_conn_min] = "AT+COMI",
+  [ble_param_conn_max] = "AT+COMA",
+  [ble_param_conn_latency] = "AT+COLA",
+  [ble_param_conn_update] = "AT+COUP",
+#endif
+};
+
+// AT command codes of each profile, see the tables in ble.h
+static const uint8_t ble_profiles[ble_profile_count][ble_param_count] = {
+  [ble_profile_low_power_idle] = {
+    [ble_param_notify] = 1,
+    [ble_param_adv_interval] = 0x9,   // 1285 ms
+    [ble_param_tx_power] = 1,         // -6 dBm
+#ifdef BLE_CONN_PARAMS_SUPPORTED
+    [ble_param_conn_min] = 2,         // 15 ms
+    [ble_param_conn_max] = 3,         // 20 ms, still carries a replay at the full LEUART rate
+    [ble_param_conn_latency] = 4,     // wakes every 5th event when there is nothing to send
+    [ble_param_conn_update] = 1,
+#endif
+  },
+  [ble_profile_interactive] = {
+    [ble_param_notify] = 1,
+    [ble_param_adv_interval] = 0x2,   // 211.25 ms
+    [ble_param_tx_power] = 2,         // 0 dBm
+#ifdef BLE_CONN_PARAMS_SUPPORTED
+    [ble_param_conn_min] = 3,         // 20 ms
+    [ble_param_conn_max] = 5,         // 30 ms
+    [ble_param_conn_latency] = 0,
+    [ble_param_conn_update] = 1,
+#endif
+  },
+  [ble_profile_bulk_transfer] = {
+    [ble_param_notify] = 1,
+    [ble_param_adv_interval] = 0x0,   // 100 ms
+    [ble_param_tx_power] = 3,         // 6 dBm
+#ifdef BLE_CONN_PARAMS_SUPPORTED
+    [ble_param_conn_min] = 0,         // 7.5 ms
+    [ble_param_conn_max] = 1,         // 10 ms
+    [ble_param_conn_latency] = 0,
+    [ble_param_conn_update] = 1,
+#endif
+  },
+};
+
+static uint8_t            applied[ble_param_count];   // values the module has confirmed
+static BLE_PROFILE        requested;
+static bool               profile_done;               // every parameter of the requested profile is applied
+static bool               reset_needed;               // a parameter changed since the last AT+RESET
+static int32_t            outstanding;                // command waiting for its reply
+static uint8_t            sent_code;                  // value sent by the outstanding command
+static uint32_t           sent_ms;
+static bool               resetting;
+static uint32_t           reset_ms;
+static bool               connected;
+static bool               connect_reported;           // connected came from OK+CONN rather than a timeout
+static char               response[BLE_AT_RESPONSE_MAX];
+static uint32_t           response_len;
+static BLE_PROFILE_STATS  profile_telemetry;
 
 
 /***************************************************************************//**
@@ -38,6 +105,124 @@
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ *  Returns the hex digit the HM10 uses for a parameter code
+ ******************************************************************************/
+static char ble_code_char(uint8_t code){
+  return (char)(code < 10 ? '0' + code : 'A' + code - 10);
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns true if the bytes received so far end with str
+ ******************************************************************************/
+static bool ble_response_ends(const char *str){
+  uint32_t length = strlen(str);
+
+  return response_len >= length && memcmp(&response[response_len - length], str, length) == 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Sends an AT command and waits for its reply
+ *
+ * @param[in] cmd
+ *  Parameter whose command is sent, or BLE_CMD_RESET
+ ******************************************************************************/
+static void ble_command_send(int32_t cmd){
+  char command[BLE_AT_RESPONSE_MAX];
+
+  if(cmd == BLE_CMD_RESET){
+      strcpy(command, "AT+RESET");
+  }else{
+      sent_code = ble_profiles[requested][cmd];
+      strcpy(command, ble_param_cmd[cmd]);
+      command[7] = ble_code_char(sent_code);
+      command[8] = 0;
+  }
+  outstanding = cmd;
+  sent_ms = letimer_time_ms(LETIMER0);
+  response_len = 0;
+  profile_telemetry.commands++;
+  leuart_start(HM10_LEUART0, command, strlen(command));
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Sends the next command the requested profile needs
+ *
+ * @details
+ *  Commands go out one at a time, the next only once the reply to the last has been received. Only parameters whose
+ *  confirmed value differs from the profile are sent, then AT+RESET if anything changed. Nothing is sent while a
+ *  central is connected, while the module is restarting, or while the LEUART is sending something else, poll and
+ *  reply handling call this again.
+ *
+ ******************************************************************************/
+static void ble_profile_next(void){
+  if(outstanding != BLE_CMD_NONE || connected || requested == ble_profile_count){
+      return;
+  }
+  if(resetting){
+      if(letimer_time_ms(LETIMER0) - reset_ms < BLE_AT_RESET_MS){
+          return;
+      }
+      resetting = false;
+  }
+  if(leuart_tx_busy(HM10_LEUART0)){
+      return;
+  }
+  for(int32_t param = 0; param < ble_param_count; param++){
+      if(applied[param] != ble_profiles[requested][param]){
+          ble_command_send(param);
+          return;
+      }
+  }
+  if(reset_needed){
+      ble_command_send(BLE_CMD_RESET);
+      return;
+  }
+  if(!profile_done){
+      profile_done = true;
+      profile_telemetry.switches++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Handles a complete reply or notification from the module
+ *
+ * @details
+ *  Notifications are matched on the end of the received bytes, since the HM10 does not terminate its replies. A
+ *  connection cancels the command in flight, which the module forwarded to the central instead of executing.
+ *
+ ******************************************************************************/
+static void ble_response_check(void){
+  if(ble_response_ends("OK+CONN")){
+      connected = true;
+      connect_reported = true;
+      outstanding = BLE_CMD_NONE;
+  }else if(ble_response_ends("OK+LOST")){
+      connected = false;
+  }else if(ble_response_ends("OK+RESET") && outstanding == BLE_CMD_RESET){
+      reset_needed = false;
+      resetting = true;
+      reset_ms = letimer_time_ms(LETIMER0);
+      outstanding = BLE_CMD_NONE;
+  }else if(response_len >= 8 && memcmp(&response[response_len - 8], "OK+Set:", 7) == 0 &&
+      outstanding != BLE_CMD_NONE && outstanding != BLE_CMD_RESET){
+      if(response[response_len - 1] != ble_code_char(sent_code)){
+          profile_telemetry.rejected++; //the module clamped it, sending it again will not change that
+      }
+      applied[outstanding] = sent_code;
+      reset_needed = true;
+      outstanding = BLE_CMD_NONE;
+  }else{
+      return;
+  }
+  response_len = 0;
+  ble_profile_next();
+}
 
 /***************************************************************************//**
  * @brief
@@ -84,6 +269,18 @@ void ble_open(uint32_t tx_event, uint32_t rx_event){
 
     leuart_open(HM10_LEUART0, &ble_leuart_open_struct);
 
+    for(uint32_t i = 0; i < ble_param_count; i++){
+        applied[i] = BLE_CODE_UNKNOWN;
+    }
+    requested = ble_profile_count;
+    profile_done = false;
+    reset_needed = false;
+    outstanding = BLE_CMD_NONE;
+    resetting = false;
+    connected = false;
+    connect_reported = false;
+    response_len = 0;
+    profile_telemetry = (BLE_PROFILE_STATS){0};
 }
 
 
@@ -105,6 +302,140 @@ void ble_write(char* string){
   leuart_start(LEUART0, string, length);
 }
 
+/***************************************************************************//**
+ * @brief
+ *  Requests a radio profile
+ *
+ * @details
+ *  Nothing is sent if the profile is already requested, and only the parameters that differ from what the module has
+ *  confirmed are sent. A new request replaces one that has not been applied yet, so the module only sees the commands
+ *  of the last request. While a central is connected the request is held until OK+LOST.
+ *
+ * @param[in] profile
+ *  Profile to apply
+ *
+ ******************************************************************************/
+
+void ble_profile_set(BLE_PROFILE profile){
+  EFM_ASSERT(profile < ble_profile_count);
+
+  if(profile == requested){
+      return;
+  }
+  requested = profile;
+  profile_done = false;
+  for(uint32_t i = 0; i < ble_param_count; i++){
+      if(applied[i] == ble_profiles[profile][i]){
+          profile_telemetry.skipped++;
+      }
+  }
+  if(connected){
+      profile_telemetry.deferred++;
+  }
+  ble_profile_next();
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns the profile last requested
+ ******************************************************************************/
+
+BLE_PROFILE ble_profile_get(void){
+  return requested;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns true once the module has confirmed every parameter of the requested profile
+ ******************************************************************************/
+
+bool ble_profile_applied(void){
+  return profile_done;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns true while a central is connected, as reported by the module or assumed from an unanswered command
+ ******************************************************************************/
+
+bool ble_connected(void){
+  return connected;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns true while an AT command is waiting for its reply or the module is booting after AT+RESET
+ *
+ * @details
+ *  Anything else written to the LEUART in that time would be taken by the module as part of a command, so frames
+ *  are held until this returns false.
+ ******************************************************************************/
+
+bool ble_at_busy(void){
+  return outstanding != BLE_CMD_NONE || resetting;
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Services the bytes received from the module
+ *
+ * @note
+ *  This function will be called in app.c each time the rx_event passed to ble_open() is serviced.
+ *
+ ******************************************************************************/
+
+void ble_rx_service(void){
+  uint8_t data[LEUART_RX_RING];
+  uint32_t count = leuart_rx_read(HM10_LEUART0, data, sizeof(data));
+
+  for(uint32_t i = 0; i < count; i++){
+      if(response_len == BLE_AT_RESPONSE_MAX){
+          memmove(response, &response[1], BLE_AT_RESPONSE_MAX - 1);
+          response_len--;
+      }
+      response[response_len++] = (char)data[i];
+      ble_response_check();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Retries a profile that is waiting and times out unanswered commands
+ *
+ * @details
+ *  A command that is not answered was forwarded to a connected central, so the module is taken to be connected until
+ *  it reports OK+LOST. If the connection was never reported (AT+NOTI not applied yet) the profile is tried again every
+ *  BLE_AT_RETRY_MS, costing the central one stray command string each time.
+ *
+ * @note
+ *  This function will be called in the LETIMER0 underflow callback.
+ *
+ ******************************************************************************/
+
+void ble_profile_poll(void){
+  uint32_t now = letimer_time_ms(LETIMER0);
+
+  if(outstanding != BLE_CMD_NONE && now - sent_ms > BLE_AT_TIMEOUT_MS){
+      profile_telemetry.timeouts++;
+      outstanding = BLE_CMD_NONE;
+      connected = true;
+      connect_reported = false;
+  }
+  if(connected && !connect_reported && now - sent_ms > BLE_AT_RETRY_MS){
+      connected = false;
+  }
+  ble_profile_next();
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Copies out the profile switch and AT command counts
+ ******************************************************************************/
+
+void ble_profile_stats(BLE_PROFILE_STATS *stats){
+  *stats = profile_telemetry;
+}
+
 /***************************************************************************//**
  * @brief
  *   BLE Test performs two functions.  First, it is a Test Driven Development
@@ -141,6 +472,9 @@ bool ble_test(char *mod_name){
   CORE_DECLARE_IRQ_STATE;
   CORE_ENTER_CRITICAL();
 
+  // The replies are polled, so the receive interrupt must not take them
+  leuart_rx_irq_enable(HM10_LEUART0, false);
+
   // This test will limit the test to the proper setup of the LEUART
   // peripheral, routing of the signals to the proper pins, pin
   // configuration, and transmit/reception verification.  The test
@@ -298,6 +632,7 @@ bool ble_test(char *mod_name){
   if (rx_disabled) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_RXBLOCKEN);
   if (!tx_en) leuart_cmd_write(HM10_LEUART0, LEUART_CMD_TXDIS);
   leuart_if_reset(HM10_LEUART0);
+  leuart_rx_irq_enable(HM10_LEUART0, true);
 
   success = true;
 
@@ -0,0 +1,109 @@
+/**
+ * @file
+ * cyclic_exec.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Time triggered cyclic executive that runs the jobs of the generated frame table
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "cyclic_exec.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t frames_run;
+static uint32_t frame_overruns;
+static uint32_t max_jitter_ms[CYCLIC_JOBS];
+static bool     started;
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Resets the cyclic executive frame counters and statistics
+ *
+ * @note
+ * LETIMER0 must be opened with a period of CYCLIC_MINOR_FRAME_MS and an underflow event that calls cyclic_exec_frame(),
+ * so every underflow releases one minor frame.
+ *
+ ******************************************************************************/
+void cyclic_exec_open(void){
+  frames_run = 0;
+  frame_overruns = 0;
+  started = false;
+  for(uint32_t i = 0; i < CYCLIC_JOBS; i++){
+      max_jitter_ms[i] = 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the jobs of the current minor frame
+ *
+ * @details
+ * The frame is selected from the LETIMER0 underflow count, so a late frame still runs the jobs of the slot it was
+ * released in. A frame counts as an overrun if the next underflow happens before its jobs finish, and every frame
+ * that never ran because of an earlier overrun is counted too. The delay from the underflow that released the frame
+ * to the start of each job is tracked as that job's jitter. The release time is the one the LETIMER0 IRQ handler
+ * recorded, not one worked out from the tick, so the clock calibration and period changes do not show up as jitter.
+ *
+ * @note
+ * This function will be called from main() when the frame event is scheduled. Event driven completions (i2c, ble)
+ * still run from the scheduler in the slack of each frame, the generator reserves the margin for them.
+ *
+ * @param[in] tick
+ * Number of the underflow that released the frame, from letimer_uf_release()
+ *
+ * @param[in] release_ms
+ * letimer_time_ms() of that underflow, from letimer_uf_release()
+ *
+ ******************************************************************************/
+void cyclic_exec_frame(uint32_t tick, uint32_t release_ms){
+  const uint8_t *frame = cyclic_frames[tick % CYCLIC_MINOR_FRAMES];
+
+  if(started && (tick - frames_run) > 1){
+      frame_overruns += tick - frames_run - 1; //frames skipped entirely
+  }
+  started = true;
+  frames_run = tick;
+
+  for(uint32_t i = 0; i < CYCLIC_FRAME_SLOTS && frame[i] != CYCLIC_END; i++){
+      uint32_t jitter = letimer_time_ms(LETIMER0) - release_ms;
+      if(jitter > max_jitter_ms[frame[i]]){
+          max_jitter_ms[frame[i]] = jitter;
+      }
+      cyclic_jobs[frame[i]].handler();
+  }
+
+  if(letimer_uf_count(LETIMER0) != tick){ //ran into the next frame
+      frame_overruns++;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of minor frames that overran or were skipped
+ ******************************************************************************/
+uint32_t cyclic_exec_overruns(void){
+  return frame_overruns;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the largest delay seen from frame release to the start of a job
+ *
+ * @param[in] job
+ * Index of the job in cyclic_jobs
+ ******************************************************************************/
+uint32_t cyclic_exec_max_jitter_ms(uint32_t job){
+  EFM_ASSERT(job < CYCLIC_JOBS);
+  return max_jitter_ms[job];
+}
@@ -0,0 +1,28 @@
+/**
+ * @file
+ * cyclic_schedule.c
+ * @brief
+ * Cyclic executive frame table, generated by tools/gen_cyclic_schedule.py from cyclic_schedule.cfg.
+ * Do not edit, change the schedule file and regenerate.
+ *
+ * minor frame 500 ms, major frame 2000 ms, margin 20000 us
+ * frame 0:   1500 us of 500000 us (app_job_sensor_sample)
+ * frame 1:      0 us of 500000 us (idle)
+ * frame 2:  65000 us of 500000 us (app_job_report)
+ * frame 3:      0 us of 500000 us (idle)
+ */
+
+#include "cyclic_exec.h"
+#include "app.h"
+
+const CYCLIC_JOB cyclic_jobs[CYCLIC_JOBS] = {
+  { app_job_sensor_sample,     1500 },  // period 2000 ms, offset 0 ms
+  { app_job_report,           65000 },  // period 2000 ms, offset 1000 ms
+};
+
+const uint8_t cyclic_frames[CYCLIC_MINOR_FRAMES][CYCLIC_FRAME_SLOTS] = {
+  { 0, CYCLIC_END },
+  { CYCLIC_END },
+  { 1, CYCLIC_END },
+  { CYCLIC_END },
+};
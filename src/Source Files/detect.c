@@ -0,0 +1,220 @@
+/**
+ * @file
+ * detect.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that watches a sensor for change points and captures the samples around them
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "detect.h"
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Integer square root, rounded down
+ ******************************************************************************/
+static uint32_t detect_isqrt(uint64_t x){
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while(bit > x){
+      bit >>= 2;
+  }
+  while(bit){
+      if(x >= root + bit){
+          x -= root + bit;
+          root = (root >> 1) + bit;
+      }else{
+          root >>= 1;
+      }
+      bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true if diff_sq > var * z^2
+ *
+ * @details
+ * diff_sq and var go up to 2^62, so the product is not formed. The quotient and remainder of diff_sq / z^2 give the
+ * same answer exactly.
+ ******************************************************************************/
+static bool detect_exceeds(uint64_t diff_sq, uint64_t var, uint32_t z){
+  uint64_t z_sq = (uint64_t)z * z;
+  uint64_t quotient = diff_sq / z_sq;
+
+  return quotient > var || (quotient == var && diff_sq % z_sq);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Restarts the baseline at a sample
+ ******************************************************************************/
+static void detect_baseline_start(DETECT_STATE *detect, int32_t value){
+  int64_t min_var = (int64_t)detect->cfg.min_sigma * detect->cfg.min_sigma << (2 * DETECT_MEAN_FRAC);
+
+  detect->mean = value * (1 << DETECT_MEAN_FRAC);
+  if(detect->var < min_var){
+      detect->var = min_var;
+  }
+  detect->samples = 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Saves a sample in the pre trigger ring, overwriting the oldest
+ ******************************************************************************/
+static void detect_pre_push(DETECT_STATE *detect, const SENSOR_SAMPLE *sample){
+  detect->pre[detect->pre_head].value = sample->value;
+  detect->pre[detect->pre_head].timestamp = sample->timestamp;
+  detect->pre_head = (detect->pre_head + 1) % DETECT_PRE_SAMPLES;
+  if(detect->pre_count < DETECT_PRE_SAMPLES){
+      detect->pre_count++;
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Sets up a change-point detector
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup() for every sensor that is watched.
+ *
+ * @param[out] detect
+ * Detector state, owned by the caller
+ *
+ * @param[in] detect_setup
+ * Sensor, baseline time constant, threshold and noise floor
+ *
+ ******************************************************************************/
+void detect_open(DETECT_STATE *detect, const DETECT_OPEN_STRUCT *detect_setup){
+  EFM_ASSERT(detect_setup->ema_shift > 0 && detect_setup->ema_shift < 16);
+  EFM_ASSERT(detect_setup->z_threshold > 0);
+
+  *detect = (DETECT_STATE){0};
+  detect->cfg = *detect_setup;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs one sample through the detector
+ *
+ * @details
+ * Samples of other sensors are ignored. While idle, the sample is tested against the baseline and then folded into it
+ * and the pre trigger ring. The sample that fires is the first of the post trigger window, the window then fills at
+ * whatever rate the caller samples at.
+ *
+ * @note
+ * This function will be called in app.c for every collected sample.
+ *
+ * @param[in] detect
+ * Detector opened by detect_open()
+ *
+ * @param[in] sample
+ * Sample that was just collected
+ *
+ * @return
+ * What the caller has to do with the sample rate, see DETECT_RESULT
+ *
+ ******************************************************************************/
+DETECT_RESULT detect_sample(DETECT_STATE *detect, const SENSOR_SAMPLE *sample){
+  int32_t value = sample->value;
+  int32_t diff;
+  int64_t diff_sq;
+  int64_t var;
+  int64_t min_var;
+  uint32_t z;
+
+  if(sample->sensor_id != detect->cfg.sensor_id){
+      return detect_idle;
+  }
+  EFM_ASSERT(value < DETECT_MAX_VALUE && value > -DETECT_MAX_VALUE);
+
+  if(detect->capturing){
+      detect->post[detect->post_count].value = value;
+      detect->post[detect->post_count].timestamp = sample->timestamp;
+      detect->post_count++;
+      if(detect->post_count < DETECT_POST_SAMPLES){
+          return detect_capturing;
+      }
+      detect->capturing = false;
+      detect_baseline_start(detect, value);
+      return detect_done;
+  }
+
+  if(detect->samples == 0){
+      detect_baseline_start(detect, value);
+      detect_pre_push(detect, sample);
+      return detect_idle;
+  }
+
+  diff = value * (1 << DETECT_MEAN_FRAC) - detect->mean;
+  diff_sq = (int64_t)diff * diff;
+  min_var = (int64_t)detect->cfg.min_sigma * detect->cfg.min_sigma << (2 * DETECT_MEAN_FRAC);
+  var = detect->var > min_var ? detect->var : min_var;
+  z = detect->cfg.z_threshold;
+
+  if(detect->samples >= detect->cfg.warmup && detect_exceeds((uint64_t)diff_sq, (uint64_t)var, z)){
+      uint32_t sigma = detect_isqrt((uint64_t)var);
+      detect->trigger_mean = detect->mean >> DETECT_MEAN_FRAC;
+      detect->trigger_sigma = sigma >> DETECT_MEAN_FRAC;
+      detect->z = (uint32_t)((uint64_t)(diff < 0 ? -diff : diff) / (sigma ? sigma : 1));
+      detect->post[0].value = value;
+      detect->post[0].timestamp = sample->timestamp;
+      detect->post_count = 1;
+      detect->capturing = true;
+      detect->events++;
+      return detect_triggered;
+  }
+
+  detect->mean += diff >> detect->cfg.ema_shift;
+  detect->var += (diff_sq - detect->var) >> detect->cfg.ema_shift;
+  detect->samples++;
+  detect_pre_push(detect, sample);
+  return detect_idle;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the report of the last capture through LOG()
+ *
+ * @details
+ * The trigger record is followed by the pre trigger samples, oldest first, and the post trigger samples, each with its
+ * time relative to the trigger. The pre trigger ring is emptied so the next report only holds newer samples.
+ *
+ * @note
+ * Called once detect_sample() returns detect_done.
+ *
+ * @param[in] detect
+ * Detector that finished a capture
+ *
+ ******************************************************************************/
+void detect_report(DETECT_STATE *detect){
+  uint32_t trigger_ms = detect->post[0].timestamp;
+  uint32_t index = (detect->pre_head + DETECT_PRE_SAMPLES - detect->pre_count) % DETECT_PRE_SAMPLES;
+
+  LOG("event %d z %d base %d sigma %d\n", detect->cfg.sensor_id, detect->z, detect->trigger_mean, detect->trigger_sigma);
+  for(uint32_t i = 0; i < detect->pre_count; i++){
+      LOG("evt %d ms = %d\n", detect->pre[index].timestamp - trigger_ms, detect->pre[index].value);
+      index = (index + 1) % DETECT_PRE_SAMPLES;
+  }
+  for(uint32_t i = 0; i < detect->post_count; i++){
+      LOG("evt %d ms = %d\n", detect->post[i].timestamp - trigger_ms, detect->post[i].value);
+  }
+  detect->pre_count = 0;
+  detect->post_count = 0;
+}
@@ -0,0 +1,438 @@
+/**
+ * @file
+ * dma.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * This module hands out the LDMA channels, builds their descriptor chains and routes their done interrupts
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "dma.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static DMA_CHANNEL_OPEN   channel_open[DMA_CHANNELS];
+static DMA_CHANNEL_STATS  channel_stats[DMA_CHANNELS];
+static bool               channel_loop[DMA_CHANNELS];
+static uint32_t           channel_done_bytes[DMA_CHANNELS];   // bytes moved between two done interrupts
+static uint32_t           channel_start_ms[DMA_CHANNELS];
+static uint32_t           active_count;
+static uint32_t           peak_active;
+static uint32_t           concurrent_ms;
+static uint32_t           concurrent_start_ms;
+static uint32_t           open_ms;
+static bool               dma_is_open;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Returns a descriptor moving count units from src to dst, done interrupt set and not linked
+ ******************************************************************************/
+static LDMA_Descriptor_t dma_descriptor(DMA_DIRECTION direction, const volatile void *src, volatile void *dst,
+                                        uint32_t count, LDMA_CtrlSize_t size){
+  LDMA_Descriptor_t m2p = LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(src, dst, count);
+  LDMA_Descriptor_t p2m = LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(src, dst, count);
+  LDMA_Descriptor_t m2m = LDMA_DESCRIPTOR_SINGLE_M2M_BYTE(src, dst, count);
+  LDMA_Descriptor_t desc;
+
+  switch(direction){
+    case dma_mem_to_periph:
+      desc = m2p;
+      break;
+    case dma_periph_to_mem:
+      desc = p2m;
+      break;
+    default:
+      desc = m2m;
+      break;
+  }
+  desc.xfer.size = size;
+  return desc;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Accounts the end of the active transfer of a channel and releases its energy mode block
+ *
+ * @note
+ * Called inside a critical section or from the LDMA IRQ
+ *
+ ******************************************************************************/
+static void dma_channel_end(uint32_t ch){
+  uint32_t now = letimer_time_ms(LETIMER0);
+
+  channel_stats[ch].active = false;
+  channel_stats[ch].active_ms += now - channel_start_ms[ch];
+  if(active_count == 2){
+      concurrent_ms += now - concurrent_start_ms;
+  }
+  active_count--;
+  if(channel_open[ch].em_block != DMA_EM_NONE){
+      sleep_unblock_mode(channel_open[ch].em_block);
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Initializes the LDMA and clears the channel table
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), before any driver that allocates a channel is opened.
+ * That is before the LETIMER0 is opened, so the utilisation window starts at letimer_pwm_open() and transfers made
+ * before it are counted as taking no time.
+ *
+ ******************************************************************************/
+void dma_open(void){
+  LDMA_Init_t ldma_values = LDMA_INIT_DEFAULT;
+
+  if(!dma_is_open){
+      LDMA_Init(&ldma_values);
+      dma_is_open = true;
+  }
+  for(uint32_t ch = 0; ch < DMA_CHANNELS; ch++){
+      channel_stats[ch] = (DMA_CHANNEL_STATS){0};
+      channel_open[ch] = (DMA_CHANNEL_OPEN){0};
+  }
+  active_count = 0;
+  peak_active = 0;
+  concurrent_ms = 0;
+  open_ms = 0;              // letimer_time_ms() when the LETIMER0 is opened
+}
+
+/***************************************************************************//**
+ * @brief
+ * Takes a free LDMA channel
+ *
+ * @details
+ * The lowest free channel is returned. Every channel is in the round robin group (LDMA_INIT_DEFAULT), so the number
+ * does not set a priority.
+ *
+ * @param[in] setup
+ * Done function and event of the channel and the energy mode it needs while a transfer is active
+ *
+ * @return
+ * The channel number, passed to the other dma_ functions
+ *
+ ******************************************************************************/
+uint32_t dma_channel_alloc(const DMA_CHANNEL_OPEN *setup){
+  uint32_t ch;
+
+  EFM_ASSERT(dma_is_open);
+  EFM_ASSERT(setup->em_block <= DMA_EM_NONE);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  for(ch = 0; ch < DMA_CHANNELS; ch++){
+      if(!channel_stats[ch].allocated){
+          break;
+      }
+  }
+  EFM_ASSERT(ch < DMA_CHANNELS); //every channel is taken
+  channel_open[ch] = *setup;
+  channel_stats[ch] = (DMA_CHANNEL_STATS){0};
+  channel_stats[ch].allocated = true;
+  CORE_EXIT_CRITICAL();
+  return ch;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Gives a channel back, stopping its transfer if one is active
+ ******************************************************************************/
+void dma_channel_free(uint32_t ch){
+  EFM_ASSERT(ch < DMA_CHANNELS && channel_stats[ch].allocated);
+
+  dma_stop(ch);
+  channel_stats[ch].allocated = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts an empty descriptor chain in the caller's storage
+ *
+ * @param[in] desc
+ * Storage for the descriptors, must stay valid while a transfer of the chain runs
+ *
+ * @param[in] max
+ * Number of descriptors desc can hold
+ *
+ * @param[in] size
+ * Unit of every descriptor of the chain (ldmaCtrlSizeByte, ldmaCtrlSizeHalf, ldmaCtrlSizeWord)
+ *
+ ******************************************************************************/
+void dma_chain_init(DMA_CHAIN *chain, LDMA_Descriptor_t *desc, uint32_t max, LDMA_CtrlSize_t size){
+  EFM_ASSERT(desc && max > 0);
+
+  chain->desc = desc;
+  chain->count = 0;
+  chain->max = max;
+  chain->size = size;
+  chain->bytes = 0;
+  chain->done_points = 0;
+  chain->loop = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a transfer to a chain
+ *
+ * @details
+ * The new descriptor is linked after the last one and takes over the done interrupt, so a linked chain raises it once
+ * at its end. A count above DMA_MAX_XFER is split over several descriptors, the incrementing side carrying on where the
+ * previous one stopped.
+ *
+ * @param[in] direction
+ * Which side is a peripheral register that must not increment
+ *
+ * @param[in] count
+ * Number of units (chain size) to move
+ *
+ ******************************************************************************/
+void dma_chain_add(DMA_CHAIN *chain, DMA_DIRECTION direction, const volatile void *src, volatile void *dst,
+                   uint32_t count){
+  EFM_ASSERT(count > 0 && !chain->loop);
+
+  while(count){
+      uint32_t n = count > DMA_MAX_XFER ? DMA_MAX_XFER : count;
+      EFM_ASSERT(chain->count < chain->max);
+
+      if(chain->count){
+          LDMA_Descriptor_t *prev = &chain->desc[chain->count - 1];
+          prev->xfer.doneIfs = 0;
+          prev->xfer.link = 1;
+          prev->xfer.linkMode = ldmaLinkModeRel;
+          prev->xfer.linkAddr = 4; //next descriptor, in words
+      }else{
+          chain->done_points = 1;
+      }
+      chain->desc[chain->count++] = dma_descriptor(direction, src, dst, n, chain->size);
+      chain->bytes += n << chain->size;
+
+      if(direction != dma_periph_to_mem){
+          src = (const volatile uint8_t *)src + (n << chain->size);
+      }
+      if(direction != dma_mem_to_periph){
+          dst = (volatile uint8_t *)dst + (n << chain->size);
+      }
+      count -= n;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Makes a chain circular, the last descriptor links back to the descriptor at index first
+ *
+ * @details
+ * A circular chain never ends on its own. Its done interrupt is raised at the end of every pass and it runs until
+ * dma_stop().
+ *
+ ******************************************************************************/
+void dma_chain_loop(DMA_CHAIN *chain, uint32_t first){
+  LDMA_Descriptor_t *last = &chain->desc[chain->count - 1];
+
+  EFM_ASSERT(chain->count && first < chain->count);
+
+  last->xfer.link = 1;
+  last->xfer.linkMode = ldmaLinkModeRel;
+  last->xfer.linkAddr = (int32_t)(first - (chain->count - 1)) * 4;
+  chain->loop = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Builds a ping-pong chain between a peripheral register and two buffers
+ *
+ * @details
+ * The chain moves count units into (or out of) buf_a, then buf_b, then buf_a again, and raises the done interrupt
+ * after each buffer. The done function or event of the channel processes the buffer that was just finished while the
+ * LDMA works on the other one, and has one buffer time to do it.
+ *
+ * @param[in] chain
+ * Chain started with room for 2 descriptors, count must not be above DMA_MAX_XFER
+ *
+ * @param[in] direction
+ * dma_periph_to_mem to fill the buffers from periph, dma_mem_to_periph to feed periph from them
+ *
+ ******************************************************************************/
+void dma_chain_ping_pong(DMA_CHAIN *chain, DMA_DIRECTION direction, volatile void *periph, void *buf_a, void *buf_b,
+                         uint32_t count){
+  EFM_ASSERT(direction != dma_mem_to_mem && count <= DMA_MAX_XFER && chain->count == 0);
+
+  if(direction == dma_periph_to_mem){
+      dma_chain_add(chain, direction, periph, buf_a, count);
+      dma_chain_add(chain, direction, periph, buf_b, count);
+  }else{
+      dma_chain_add(chain, direction, buf_a, periph, count);
+      dma_chain_add(chain, direction, buf_b, periph, count);
+  }
+  chain->desc[0].xfer.doneIfs = 1;
+  chain->done_points = 2;
+  dma_chain_loop(chain, 0);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts a chain on a channel
+ *
+ * @details
+ * The energy mode block of the channel is taken here and released when the transfer is done or stopped.
+ *
+ * @param[in] cfg
+ * Request source of the transfer, LDMA_TRANSFER_CFG_PERIPHERAL() or LDMA_TRANSFER_CFG_MEMORY()
+ *
+ * @param[in] chain
+ * Built chain, only its descriptors have to stay valid after the call
+ *
+ ******************************************************************************/
+void dma_start(uint32_t ch, const LDMA_TransferCfg_t *cfg, const DMA_CHAIN *chain){
+  EFM_ASSERT(ch < DMA_CHANNELS && channel_stats[ch].allocated);
+  EFM_ASSERT(chain->count);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(!channel_stats[ch].active);
+  if(channel_open[ch].em_block != DMA_EM_NONE){
+      sleep_block_mode(channel_open[ch].em_block);
+  }
+  channel_stats[ch].active = true;
+  channel_loop[ch] = chain->loop;
+  channel_done_bytes[ch] = chain->done_points ? chain->bytes / chain->done_points : chain->bytes;
+  channel_start_ms[ch] = letimer_time_ms(LETIMER0);
+  active_count++;
+  if(active_count == 2){
+      concurrent_start_ms = channel_start_ms[ch];
+  }
+  if(active_count > peak_active){
+      peak_active = active_count;
+  }
+  LDMA_StartTransfer(ch, cfg, chain->desc);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Finishes the transfer of a channel whose descriptors do not raise the done interrupt
+ *
+ * @details
+ * For transfers whose end is seen by the driver rather than the LDMA (ex. the LEUART TXC after the last byte, or the
+ * SPI TX channel which ends before its RX channel). The channel must have moved all its data.
+ *
+ ******************************************************************************/
+void dma_done(uint32_t ch){
+  EFM_ASSERT(ch < DMA_CHANNELS && channel_stats[ch].active && !channel_loop[ch]);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  channel_stats[ch].transfers++;
+  channel_stats[ch].bytes += channel_done_bytes[ch];
+  dma_channel_end(ch);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stops the transfer of a channel, the way to end a circular chain
+ ******************************************************************************/
+void dma_stop(uint32_t ch){
+  EFM_ASSERT(ch < DMA_CHANNELS);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(channel_stats[ch].active){
+      LDMA_StopTransfer(ch);
+      channel_stats[ch].transfers++;
+      dma_channel_end(ch);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true from dma_start() until the transfer of the channel is done or stopped
+ ******************************************************************************/
+bool dma_active(uint32_t ch){
+  EFM_ASSERT(ch < DMA_CHANNELS);
+  return channel_stats[ch].active;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the utilisation of every channel
+ *
+ * @details
+ * Transfers still running are counted up to now.
+ *
+ * @param[out] stats
+ * Per channel transfers, bytes, active time and utilisation, the peak number of channels active at once and the time
+ * more than one was active
+ *
+ ******************************************************************************/
+void dma_stats(DMA_STATS *stats){
+  uint32_t now;
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  now = letimer_time_ms(LETIMER0);
+  stats->elapsed_ms = now - open_ms;
+  stats->allocated = 0;
+  for(uint32_t ch = 0; ch < DMA_CHANNELS; ch++){
+      stats->channel[ch] = channel_stats[ch];
+      if(channel_stats[ch].active){
+          stats->channel[ch].active_ms += now - channel_start_ms[ch];
+      }
+      stats->channel[ch].util_permille = stats->elapsed_ms ?
+          (uint32_t)((uint64_t)stats->channel[ch].active_ms * 1000 / stats->elapsed_ms) : 0;
+      stats->allocated += channel_stats[ch].allocated;
+  }
+  stats->peak_active = peak_active;
+  stats->concurrent_ms = concurrent_ms + (active_count >= 2 ? now - concurrent_start_ms : 0);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Interrupt handler for the LDMA
+ *
+ * @details
+ * Each channel with a done interrupt is ended (unless its chain is circular) before its done function runs, so the done
+ * function can start the next transfer on the same channel. Then the done event of the channel is scheduled.
+ *
+ * @note
+ * An LDMA error halts here so it can be seen in the debugger
+ ******************************************************************************/
+void LDMA_IRQHandler(void){
+  uint32_t int_flag = LDMA->IF & LDMA->IEN;
+  LDMA->IFC = int_flag;
+
+  EFM_ASSERT(!(int_flag & LDMA_IF_ERROR));
+
+  for(uint32_t ch = 0; ch < DMA_CHANNELS; ch++){
+      if(!(int_flag & (1 << ch)) || !channel_stats[ch].active){
+          continue;
+      }
+      channel_stats[ch].transfers++;
+      channel_stats[ch].bytes += channel_done_bytes[ch];
+      if(!channel_loop[ch]){
+          dma_channel_end(ch);
+      }
+      if(channel_open[ch].done_func){
+          channel_open[ch].done_func(channel_open[ch].ctx);
+      }
+      if(channel_open[ch].done_cb){
+          add_scheduled_event(channel_open[ch].done_cb);
+      }
+  }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * frame.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Builds the binary link frame in place around a payload
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "frame.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// CRC-32 remainders of a single nibble, reflected polynomial 0xEDB88320
+static const uint32_t crc32_nibble[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Updates a running CRC-32 with a block of data
+ *
+ * @details
+ * Table driven one nibble at a time, so the table is 64 bytes of flash instead of 1 KB.
+ *
+ * @param[in] crc
+ * CRC returned by the previous call, 0 for the first block
+ *
+ * @param[in] data
+ * Bytes to add to the CRC
+ *
+ * @param[in] length
+ * Number of bytes
+ *
+ * @return
+ * The updated CRC
+ ******************************************************************************/
+uint32_t frame_crc32(uint32_t crc, const uint8_t *data, uint32_t length){
+  crc = ~crc;
+  while(length--){
+      crc ^= *data++;
+      crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+      crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Writes the header and CRC of a frame around a payload that is already in place
+ *
+ * @details
+ * The payload must already be at frame + FRAME_HEADER_SIZE, usually written there directly by a DMA transfer. The
+ * header is written in front of it and the CRC behind it, so the payload is never copied.
+ *
+ * @param[in] frame
+ * Buffer of at least FRAME_SIZE(payload_len) bytes
+ *
+ * @param[in] type
+ * Frame type
+ *
+ * @param[in] seq
+ * Sequence number of the frame
+ *
+ * @param[in] payload_len
+ * Bytes of payload at frame + FRAME_HEADER_SIZE
+ *
+ * @return
+ * Total length of the frame to transmit
+ ******************************************************************************/
+uint32_t frame_seal(uint8_t *frame, FRAME_TYPE type, uint8_t seq, uint32_t payload_len){
+  uint32_t crc;
+  uint8_t *trailer = frame + FRAME_HEADER_SIZE + payload_len;
+
+  EFM_ASSERT(payload_len <= FRAME_PAYLOAD_MAX);
+
+  frame[0] = FRAME_SYNC0;
+  frame[1] = FRAME_SYNC1;
+  frame[2] = (uint8_t)type;
+  frame[3] = seq;
+  frame[4] = (uint8_t)payload_len;
+  frame[5] = (uint8_t)(payload_len >> 8);
+
+  crc = frame_crc32(0, &frame[2], FRAME_HEADER_SIZE - 2 + payload_len);
+  trailer[0] = (uint8_t)crc;
+  trailer[1] = (uint8_t)(crc >> 8);
+  trailer[2] = (uint8_t)(crc >> 16);
+  trailer[3] = (uint8_t)(crc >> 24);
+
+  return FRAME_SIZE(payload_len);
+}
@@ -0,0 +1,342 @@
+/**
+ * @file
+ * governor.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that holds the charge used to a battery lifetime budget by trading sample rate, reports and radio frames
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "governor.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+// Counters the charge of a window is taken from, all free running so a window is the difference of two snapshots
+typedef struct {
+  uint32_t      time_ms;
+  uint32_t      state_ms[POWER_STATES];
+  uint32_t      sample_cycles;
+  uint32_t      log_frames;
+  uint32_t      log_bytes;
+  uint32_t      replay_frames;
+  uint32_t      replay_bytes;
+} GOVERNOR_SNAPSHOT;
+
+static GOVERNOR_OPEN_STRUCT governor_cfg;
+static GOVERNOR_SNAPSHOT    window_start;
+static uint32_t             sample_cycles;
+static uint32_t             governor_level;
+static uint64_t             budget_na;      // average current the lifetime allows
+static uint64_t             consumed_nc;
+static uint64_t             elapsed_ms;     // kept in 64 bits, a deployment outlasts the 49 day wrap of the ms counters
+static GOVERNOR_STATS       governor_telemetry;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Reads the counters the charge is estimated from
+ ******************************************************************************/
+static void governor_snapshot(GOVERNOR_SNAPSHOT *snapshot){
+  POWER_STATS power;
+  LOG_STATS log;
+  REPLAY_STATS replay;
+
+  power_stats(&power);
+  log_stats(&log);
+  replay_stats(&replay);
+  snapshot->time_ms = letimer_time_ms(LETIMER0);
+  for(uint32_t state = 0; state < POWER_STATES; state++){
+      snapshot->state_ms[state] = power.state_ms[state];
+  }
+  snapshot->sample_cycles = sample_cycles;
+  snapshot->log_frames = log.frames;
+  snapshot->log_bytes = log.wire_bytes;
+  snapshot->replay_frames = replay.frames;
+  snapshot->replay_bytes = replay.wire_bytes;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns how far a counter moved, a counter that went back was restarted (replay_start() clears its telemetry)
+ ******************************************************************************/
+static uint32_t governor_delta(uint32_t now, uint32_t last){
+  return now < last ? now : now - last;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Estimates the charge used between two snapshots in nC
+ ******************************************************************************/
+static uint64_t governor_window_charge(const GOVERNOR_SNAPSHOT *start, const GOVERNOR_SNAPSHOT *end, uint32_t window_ms){
+  uint64_t charge = (uint64_t)window_ms * governor_cfg.base_ua;
+  uint32_t frames;
+  uint32_t bytes;
+
+  for(uint32_t state = 0; state < POWER_STATES; state++){
+      charge += (uint64_t)(end->state_ms[state] - start->state_ms[state]) * governor_cfg.state_ua[state];
+  }
+  frames = governor_delta(end->log_frames, start->log_frames) + governor_delta(end->replay_frames, start->replay_frames);
+  bytes = governor_delta(end->log_bytes, start->log_bytes) + governor_delta(end->replay_bytes, start->replay_bytes);
+  charge += (uint64_t)(end->sample_cycles - start->sample_cycles) * governor_cfg.sample_nc;
+  charge += (uint64_t)frames * governor_cfg.frame_nc;
+  charge += (uint64_t)bytes * governor_cfg.byte_nc;
+  return charge;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the sample period, deadband and coalescing window of a level
+ *
+ * @details
+ * The period is interpolated in rate, 1 / period moves linearly from 1 / period_max_ms at level 0 to 1 / period_min_ms
+ * at GOVERNOR_LEVEL_FULL, since the sampling charge is proportional to the rate.
+ *
+ ******************************************************************************/
+static void governor_knobs_set(uint32_t level){
+  uint64_t min = governor_cfg.period_min_ms;
+  uint64_t max = governor_cfg.period_max_ms;
+  uint32_t fidelity_lost = GOVERNOR_LEVEL_FULL - level;
+
+  governor_telemetry.level = level;
+  governor_telemetry.period_ms = (uint32_t)(min * max * GOVERNOR_LEVEL_FULL / (max * level + min * fidelity_lost));
+  governor_telemetry.deadband_permille = governor_cfg.deadband_min_permille +
+      (governor_cfg.deadband_max_permille - governor_cfg.deadband_min_permille) * fidelity_lost / GOVERNOR_LEVEL_FULL;
+  governor_telemetry.coalesce_ms = governor_cfg.coalesce_min_ms +
+      (governor_cfg.coalesce_max_ms - governor_cfg.coalesce_min_ms) * fidelity_lost / GOVERNOR_LEVEL_FULL;
+  log_coalesce_set(governor_telemetry.coalesce_ms);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Sets up the governor at the full level and starts the budget trajectory
+ *
+ * @details
+ * The battery is taken to be full when this is called. The first window starts here.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after power_open(), log_open() and replay_open() since
+ * their telemetry is the first snapshot.
+ *
+ * @param[in] governor_setup
+ * Battery, lifetime, charge estimates and the bounds of the knobs
+ *
+ ******************************************************************************/
+void governor_open(const GOVERNOR_OPEN_STRUCT *governor_setup){
+  EFM_ASSERT(governor_setup->capacity_uah > 0 && governor_setup->lifetime_days > 0);
+  EFM_ASSERT(governor_setup->window_ms > 0 && governor_setup->horizon_ms > 0);
+  EFM_ASSERT(governor_setup->period_min_ms > 0 && governor_setup->period_min_ms <= governor_setup->period_max_ms);
+  EFM_ASSERT(governor_setup->deadband_min_permille <= governor_setup->deadband_max_permille);
+  EFM_ASSERT(governor_setup->coalesce_min_ms <= governor_setup->coalesce_max_ms);
+
+  governor_cfg = *governor_setup;
+  budget_na = (uint64_t)governor_cfg.capacity_uah * 1000 / ((uint64_t)governor_cfg.lifetime_days * 24);
+  consumed_nc = 0;
+  elapsed_ms = 0;
+  sample_cycles = 0;
+  governor_telemetry = (GOVERNOR_STATS){0};
+  governor_level = GOVERNOR_LEVEL_FULL;
+  governor_knobs_set(governor_level);
+  governor_snapshot(&window_start);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Closes the window once it is long enough, compares the charge with the budget and moves the level
+ *
+ * @details
+ * The reserve (budget minus charge used so far) is spread over horizon_ms to give the current the next windows should
+ * average. The level is moved by GOVERNOR_GAIN_PERMILLE of the relative error between that target and the current of
+ * the window just closed, so a deficit is paid back and a reserve is spent on data over the horizon rather than at
+ * once. The state of the governor is sent as two LOG() records, and a third if the DCDC was held in low noise mode
+ * for more than POWER_QUIET_MAX_PERMILLE of the window, a quiet request held past its measurement.
+ *
+ * @note
+ * This function will be called on every LETIMER0 underflow callback, or after every cyclic executive frame. Calling it
+ * more often is harmless, nothing is done until window_ms has passed.
+ *
+ * @return
+ * True if the sample period changed, the caller applies governor_period_ms() to the LETIMER0
+ *
+ ******************************************************************************/
+bool governor_service(void){
+  GOVERNOR_SNAPSHOT now;
+  uint32_t window_ms;
+  uint64_t window_nc;
+  uint64_t budget_nc;
+  int64_t  reserve_nc;
+  int64_t  target_na;
+  int64_t  window_na;
+  int64_t  error;
+  int32_t  level;
+  uint32_t last_period_ms = governor_telemetry.period_ms;
+
+  now.time_ms = letimer_time_ms(LETIMER0);
+  window_ms = now.time_ms - window_start.time_ms;
+  if(window_ms < governor_cfg.window_ms){
+      return false;
+  }
+  governor_snapshot(&now);
+  window_ms = now.time_ms - window_start.time_ms;
+  window_nc = governor_window_charge(&window_start, &now, window_ms);
+  governor_telemetry.quiet_permille = (uint32_t)((uint64_t)(now.state_ms[power_state_quiet] -
+      window_start.state_ms[power_state_quiet]) * 1000 / window_ms);
+  window_start = now;
+
+  consumed_nc += window_nc;
+  elapsed_ms += window_ms;
+  budget_nc = budget_na * elapsed_ms / 1000;
+  reserve_nc = (int64_t)budget_nc - (int64_t)consumed_nc;
+  target_na = (int64_t)budget_na + reserve_nc * 1000 / governor_cfg.horizon_ms;
+  if(target_na < 1){
+      target_na = 1; //behind by more than a horizon of budget, the error saturates and the level heads for 0
+  }
+  window_na = (int64_t)(window_nc * 1000 / window_ms);
+
+  error = (target_na - window_na) * 1000 / target_na;
+  if(error > 1000){
+      error = 1000;
+  }else if(error < -1000){
+      error = -1000;
+  }
+  if(error > GOVERNOR_HYST_PERMILLE || error < -GOVERNOR_HYST_PERMILLE){
+      int32_t step = (int32_t)(error * GOVERNOR_GAIN_PERMILLE / 1000);
+
+      if(step > GOVERNOR_STEP_MAX){
+          step = GOVERNOR_STEP_MAX;
+      }else if(step < -GOVERNOR_STEP_MAX){
+          step = -GOVERNOR_STEP_MAX;
+      }
+      level = (int32_t)governor_level + step;
+      if(level < 0){
+          level = 0;
+      }else if(level > GOVERNOR_LEVEL_FULL){
+          level = GOVERNOR_LEVEL_FULL;
+      }
+      if((uint32_t)level != governor_level){
+          governor_level = (uint32_t)level;
+          governor_knobs_set(governor_level);
+          governor_telemetry.adjustments++;
+      }
+  }
+
+  governor_telemetry.elapsed_s = (uint32_t)(elapsed_ms / 1000);
+  governor_telemetry.consumed_uah = (uint32_t)(consumed_nc / GOVERNOR_NC_PER_UAH);
+  governor_telemetry.budget_uah = (uint32_t)(budget_nc / GOVERNOR_NC_PER_UAH);
+  governor_telemetry.reserve_uah = (int32_t)(reserve_nc / GOVERNOR_NC_PER_UAH);
+  governor_telemetry.window_na = (uint32_t)window_na;
+  governor_telemetry.target_na = (uint32_t)target_na;
+  governor_telemetry.average_na = (uint32_t)(consumed_nc * 1000 / elapsed_ms);
+  governor_telemetry.projected_days = governor_telemetry.average_na ?
+      (uint32_t)((uint64_t)governor_cfg.capacity_uah * 1000 / governor_telemetry.average_na / 24) : 0;
+
+  LOG("gov %d nA target %d nA reserve %d uAh days %d\n", governor_telemetry.window_na, governor_telemetry.target_na,
+      governor_telemetry.reserve_uah, governor_telemetry.projected_days);
+  LOG("gov level %d period %d ms deadband %d coalesce %d ms\n", governor_telemetry.level, governor_telemetry.period_ms,
+      governor_telemetry.deadband_permille, governor_telemetry.coalesce_ms);
+  if(governor_telemetry.quiet_permille > POWER_QUIET_MAX_PERMILLE){
+      governor_telemetry.quiet_windows++;
+      LOG("gov quiet supply %d permille of the window\n", governor_telemetry.quiet_permille);
+  }
+
+  return governor_telemetry.period_ms != last_period_ms;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Counts a sample cycle of the sensor registry, charged at sample_nc
+ *
+ * @note
+ * This function will be called each time the sample cycle is started.
+ *
+ ******************************************************************************/
+void governor_sample_cycle(void){
+  sample_cycles++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the sample period of the current level in ms
+ ******************************************************************************/
+uint32_t governor_period_ms(void){
+  return governor_telemetry.period_ms;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets up the deadband state of one reported value, its first sample is always reported
+ *
+ * @param[in] floor
+ * Sample units, the deadband of values nearer 0 than this is a share of floor instead of the value
+ *
+ ******************************************************************************/
+void governor_report_init(GOVERNOR_REPORT *report, int32_t floor){
+  EFM_ASSERT(floor > 0);
+  report->floor = floor;
+  report->value = 0;
+  report->timestamp = 0;
+  report->reported = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Decides if a sample is worth reporting at the current deadband
+ *
+ * @details
+ * A sample is reported when it moved deadband_permille of the last reported value (or of floor, whichever is larger)
+ * or when report_max_ms has passed since the last report. At a deadband of 0 every sample is reported.
+ *
+ * @param[in] report
+ * Deadband state of the value, updated when the sample is reported
+ *
+ * @param[in] sample
+ * Sample the caller is about to report
+ *
+ * @return
+ * True if the caller should report the sample
+ *
+ ******************************************************************************/
+bool governor_report_due(GOVERNOR_REPORT *report, const SENSOR_SAMPLE *sample){
+  int64_t delta = (int64_t)sample->value - report->value;
+  int64_t scale = report->value;
+
+  delta = delta < 0 ? -delta : delta;
+  scale = scale < 0 ? -scale : scale;
+  if(scale < report->floor){
+      scale = report->floor;
+  }
+  if(report->reported && sample->timestamp - report->timestamp < governor_cfg.report_max_ms &&
+     delta * 1000 < scale * governor_telemetry.deadband_permille){
+      governor_telemetry.suppressed++;
+      return false;
+  }
+  report->value = sample->value;
+  report->timestamp = sample->timestamp;
+  report->reported = true;
+  governor_telemetry.reports++;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the governor telemetry
+ *
+ * @param[out] stats
+ * Charge used against the budget as of the last window, the level and the knobs it set
+ *
+ ******************************************************************************/
+void governor_stats(GOVERNOR_STATS *stats){
+  *stats = governor_telemetry;
+}
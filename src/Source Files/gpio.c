@@ -76,10 +76,20 @@ void gpio_open(void){
   GPIO_PinModeSet(SI1133_SCL_PORT, SI1133_SCL_PIN, gpioModeWiredAnd, SI1133_SCL_DEFAULT);
   GPIO_PinModeSet(SI1133_SDA_PORT, SI1133_SDA_PIN, gpioModeWiredAnd, SI1133_SDA_DEFAULT);
 
+  //Configure host I2C slave lines, pulled up so the bus idles high when no host is attached
+  GPIO_PinModeSet(HOST_SCL_PORT, HOST_SCL_PIN, gpioModeWiredAndPullUp, HOST_I2C_DEFAULT);
+  GPIO_PinModeSet(HOST_SDA_PORT, HOST_SDA_PIN, gpioModeWiredAndPullUp, HOST_I2C_DEFAULT);
+
   //Configure UART pins
   GPIO_DriveStrengthSet(LEUART_TX_PORT, LEUART_DRIVE_STRENGTH);
   GPIO_PinModeSet(LEUART_TX_PORT, LEUART_TX_PIN, gpioModePushPull, LEUART_DEFAULT);
 
   GPIO_PinModeSet(LEUART_RX_PORT, LEUART_RX_PIN, gpioModeInput, LEUART_DEFAULT);
 
+  //Configure MX25 SPI flash pins
+  GPIO_PinModeSet(MX25_MOSI_PORT, MX25_MOSI_PIN, gpioModePushPull, MX25_DEFAULT);
+  GPIO_PinModeSet(MX25_MISO_PORT, MX25_MISO_PIN, gpioModeInput, MX25_DEFAULT);
+  GPIO_PinModeSet(MX25_SCLK_PORT, MX25_SCLK_PIN, gpioModePushPull, MX25_DEFAULT);
+  GPIO_PinModeSet(MX25_CS_PORT, MX25_CS_PIN, gpioModePushPull, MX25_CS_DEFAULT);
+
 }
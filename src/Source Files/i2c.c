@@ -14,11 +14,13 @@
 // Include files
 //***********************************************************************************
 #include "i2c.h"
+#include <string.h>
 
 //***********************************************************************************
 // Private Variables
 //***********************************************************************************
 static I2C_STATE_MACHINE i2c0_state, i2c1_state;
+static I2C_SLAVE_STATE i2c0_slave;
 
 //***********************************************************************************
 // Private functions
@@ -60,6 +62,11 @@ static void Ack_Func(I2C_STATE_MACHINE *i2c_sm){
     case initialize_device_read:
       break;
     case write_data:
+      if(i2c_sm->num_of_data_bytes == 0){ //command only write, nothing follows the register/command byte
+          i2c_sm->i2cx->CMD = I2C_CMD_STOP;
+          i2c_sm->current_state = recieve_data;
+          break;
+      }
       i2c_sm->num_of_data_bytes--;
       i2c_sm->i2cx->TXDATA = (*(i2c_sm->data) >> (8*i2c_sm->num_of_data_bytes)) & 0xff;
       if(i2c_sm->num_of_data_bytes == 0){
@@ -165,6 +172,101 @@ static void Stop_Func(I2C_STATE_MACHINE *i2c_sm){
 }
 
 
+/***************************************************************************//**
+ * @brief
+ * Returns the next byte of the register map served to the host
+ ******************************************************************************/
+static uint8_t slave_next_byte(I2C_SLAVE_STATE *slave){
+  uint8_t data = slave->map[slave->front][slave->reg];
+
+  slave->reg = (slave->reg + 1) % I2C_SLAVE_MAP_SIZE;
+  slave->bytes_served++;
+  return data;
+}
+
+/***************************************************************************//**
+ * @brief
+ * This state machine function services all the interrupts of an i2c slave
+ *
+ * @details
+ * The address match wakes the processor from EM2/EM3 with SCL held low. On the first address match of a transaction a
+ * newer snapshot, if one was published, becomes the one served, and EM2 is blocked until the STOP so the peripheral
+ * keeps its clock. A repeated start keeps the same snapshot, so a register pointer write followed by a read is served
+ * from one consistent map. Received bytes are acked by AUTOACK, the first one sets the register pointer. Every byte
+ * the host reads is loaded on the address match or on the host's ACK of the previous byte.
+ *
+ * The address byte sits in RXDATA when ADDR is raised, so RXDATAV comes in the same interrupt. Reading the address
+ * empties the buffer, so RXDATAV is only serviced while STATUS still shows a byte, otherwise the second read would
+ * underflow and set the register pointer from stale data. tools/i2c_slave_sim.c plays this sequence into a model of
+ * the registers.
+ *
+ * @note
+ * This function is called within the I2C0 interrupt request handler while I2C0 is opened as a slave
+ *
+ ******************************************************************************/
+static void slave_func(I2C_SLAVE_STATE *slave, uint32_t int_flag){
+  I2C_TypeDef *i2c = slave->i2cx;
+
+  if(int_flag & I2C_IF_ADDR){
+      uint32_t address = i2c->RXDATA;
+      if(!slave->in_transaction){
+          slave->in_transaction = true;
+          slave->transactions++;
+          sleep_block_mode(I2C_EM_BLOCK);
+          if(slave->pending){
+              slave->front ^= 1;
+              slave->pending = false;
+          }
+      }
+      if(address & read){
+          i2c->TXDATA = slave_next_byte(slave);
+      }else{
+          slave->pointer_set = false;
+      }
+  }
+  if((int_flag & I2C_IF_RXDATAV) && (i2c->STATUS & I2C_STATUS_RXDATAV)){
+      uint32_t data = i2c->RXDATA;
+      if(!slave->pointer_set){
+          slave->reg = data % I2C_SLAVE_MAP_SIZE;
+          slave->pointer_set = true;
+      } //the map is read only, any other written byte is dropped
+  }
+  if(int_flag & I2C_IF_ACK){
+      i2c->TXDATA = slave_next_byte(slave);
+  }
+  if(int_flag & I2C_IF_NACK){ //host read its last byte
+      i2c->CMD = I2C_CMD_CLEARTX;
+  }
+  if(int_flag & (I2C_IF_SSTOP | I2C_IF_BUSERR)){
+      if(slave->in_transaction){
+          slave->in_transaction = false;
+          sleep_unblock_mode(I2C_EM_BLOCK);
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets up a peripheral opened with master false to answer at its slave address
+ *
+ * @note
+ * Only I2C0 can match its address in EM2/EM3, so that is the only peripheral supported as a slave
+ *
+ ******************************************************************************/
+static void slave_open(I2C_TypeDef *i2c, uint32_t address){
+  EFM_ASSERT(i2c == I2C0);
+  EFM_ASSERT(address > 0x07 && address < 0x78); //reserved addresses
+
+  memset(&i2c0_slave, 0, sizeof(i2c0_slave));
+  i2c0_slave.i2cx = i2c;
+
+  i2c->SADDR = address << _I2C_SADDR_ADDR_SHIFT;
+  i2c->SADDRMASK = _I2C_SADDRMASK_MASK_MASK; //match all 7 bits
+  i2c->CTRL |= I2C_CTRL_AUTOACK;
+  i2c->IFC = _I2C_IFC_MASK;
+  i2c->IEN = I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_SSTOP | I2C_IEN_BUSERR;
+}
+
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
@@ -195,7 +297,8 @@ static void Stop_Func(I2C_STATE_MACHINE *i2c_sm){
  * Number of bytes desired to read off or write to the slave device
  *
  * @param[in] desired_register_address
- * Address of the slave register desired to read or write to
+ * Address of the slave register desired to read or write to. Use I2C_NO_REGISTER on a read to skip the register write and
+ * read directly from the device. A write of 0 bytes sends only the register address, which is how command bytes are sent.
  *
  * @param[in] app_cb
  * Call back function to be serviced after i2c operation completes
@@ -230,7 +333,12 @@ void i2c_start(I2C_TypeDef *i2c, uint32_t device_address, OPERATION_MODE mode, u
   i2c_local_sm->device_address = device_address;
 
   i2c->CMD = I2C_CMD_START;
-  i2c->TXDATA = (device_address << 1) | write;
+  if(mode == read && desired_register_address == I2C_NO_REGISTER){ //device returns data without a register write (ex. si7021 no hold measurement)
+      i2c_local_sm->current_state = initialize_device_read;
+      i2c->TXDATA = (device_address << 1) | read;
+  }else{
+      i2c->TXDATA = (device_address << 1) | write;
+  }
 
 }
 
@@ -301,6 +409,10 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup){
   i2c->IEN |= (I2C_IEN_RXDATAV * i2c_setup->rxdatav_irq_enable);
   i2c->IEN |= (I2C_IEN_MSTOP * i2c_setup->stop_irq_enable);
 
+  if(!i2c_setup->master){
+      slave_open(i2c, i2c_setup->slave_address);
+  }
+
   if(i2c == I2C0){
       NVIC_EnableIRQ(I2C0_IRQn);
   }
@@ -311,7 +423,9 @@ void i2c_open(I2C_TypeDef *i2c, I2C_OPEN_STRUCT *i2c_setup){
 
 
 
-  i2c_bus_reset(i2c);
+  if(i2c_setup->master){
+      i2c_bus_reset(i2c);
+  }
 
 }
 
@@ -371,6 +485,66 @@ bool i2c_available(I2C_TypeDef *i2c){
   return false;
 }
 
+/***************************************************************************//**
+ * @brief
+ * Publishes a new snapshot of the register map served to the host
+ *
+ * @details
+ * The snapshot is written into the map the ISR is not serving from and marked pending. The ISR swaps maps at the start
+ * of the next host transaction, so a host never reads a map that is half old and half new, and a transaction in
+ * progress is never disturbed. Bytes past length read as 0.
+ *
+ * @note
+ * Called from the main loop by the app whenever a new reading is available
+ *
+ * @param[in] i2c
+ * I2C peripheral opened as a slave (I2C0)
+ *
+ * @param[in] data
+ * Register map contents starting at register 0
+ *
+ * @param[in] length
+ * Bytes of data, at most I2C_SLAVE_MAP_SIZE
+ *
+ ******************************************************************************/
+void i2c_slave_publish(I2C_TypeDef *i2c, const uint8_t *data, uint32_t length){
+  uint32_t back;
+
+  EFM_ASSERT(i2c == I2C0 && i2c0_slave.i2cx);
+  EFM_ASSERT(length <= I2C_SLAVE_MAP_SIZE);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  i2c0_slave.pending = false; //keeps the ISR from swapping to the map being written
+  back = i2c0_slave.front ^ 1;
+  CORE_EXIT_CRITICAL();
+
+  memcpy(i2c0_slave.map[back], data, length);
+  memset(&i2c0_slave.map[back][length], 0, I2C_SLAVE_MAP_SIZE - length);
+
+  CORE_ENTER_CRITICAL();
+  i2c0_slave.pending = true;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of register bytes the host has read since the slave was opened
+ ******************************************************************************/
+uint32_t i2c_slave_bytes_served(I2C_TypeDef *i2c){
+  EFM_ASSERT(i2c == I2C0);
+  return i2c0_slave.bytes_served;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of host transactions addressed to the slave since it was opened
+ ******************************************************************************/
+uint32_t i2c_slave_transactions(I2C_TypeDef *i2c){
+  EFM_ASSERT(i2c == I2C0);
+  return i2c0_slave.transactions;
+}
+
 /***************************************************************************//**
  * @brief
  * Interrupt handler for the I2C0 peripheral
@@ -379,12 +553,18 @@ bool i2c_available(I2C_TypeDef *i2c){
  * This function handles all interrupts triggered within the i2c0 peripheral. It will call state machine functions to service the interrupt triggered based on its current state.
  *
  * @note
- * This function will respond and handle the ACK, RXDATAV, and MSTOP interrupts
+ * This function will respond and handle the ACK, RXDATAV, and MSTOP interrupts, or hand every interrupt to the slave
+ * state machine when I2C0 was opened as a slave
  ******************************************************************************/
 void I2C0_IRQHandler(void){
   uint32_t int_flag = I2C0->IF & I2C0->IEN;
   I2C0->IFC = int_flag;
 
+  if(i2c0_slave.i2cx){
+      slave_func(&i2c0_slave, int_flag);
+      return;
+  }
+
   if(int_flag & I2C_IF_ACK) {
       Ack_Func(&i2c0_state);
   }
@@ -27,10 +27,51 @@
 static uint32_t scheduled_comp0_cb;
 static uint32_t scheduled_comp1_cb;
 static uint32_t scheduled_uf_cb;
+static uint32_t letimer0_period_cnt;                     // COMP0 of the period being counted down
+static uint32_t letimer0_next_period_cnt;                // COMP0 loaded on the next underflow
+static volatile uint32_t letimer0_uf_count;
+static float letimer0_period;
+static float letimer0_active_period;
+static uint32_t letimer0_clock_mhz = LETIMER_HZ * 1000;  // measured ULFRCO frequency in mHz
+static volatile uint32_t letimer0_pending_clock_mhz;     // letimer_clock_set() value applied on the next underflow, 0 for none
+static volatile uint64_t letimer0_elapsed_us;            // time of the last underflow
+static volatile uint32_t letimer0_uf_ticks;              // ticks counted up to the last underflow
+static volatile uint32_t letimer0_uf_ref;                // reference count captured at the last underflow
+static volatile uint32_t letimer0_uf_time_ms;            // letimer_time_ms() of the last underflow
+static uint32_t (*letimer0_uf_capture)(void);
+static bool letimer0_opened;                             // the time base is valid, letimer_time_ms() reads 0 before
 
 //***********************************************************************************
 // Private functions
 //***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Converts a time in seconds to LETIMER0 ticks at the current clock estimate
+ ******************************************************************************/
+static uint32_t letimer0_ticks(float seconds){
+  return (uint32_t)(seconds * letimer0_clock_mhz / 1000 + 0.5f);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Converts a number of LETIMER0 ticks to microseconds at the current clock estimate
+ ******************************************************************************/
+static uint64_t letimer0_ticks_us(uint32_t ticks){
+  return (uint64_t)ticks * 1000000000 / letimer0_clock_mhz;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the COMP1 value for an active period, clamped to the period
+ ******************************************************************************/
+static uint32_t letimer0_active_cnt(float active_period){
+  uint32_t period_active_cnt = letimer0_ticks(active_period);
+
+  if(period_active_cnt > letimer0_next_period_cnt){
+      period_active_cnt = letimer0_next_period_cnt;
+  }
+  return period_active_cnt;
+}
 
 
 //***********************************************************************************
@@ -124,11 +165,18 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
   /* Calculate the value of COMP0 and COMP1 and load these control registers
    * with the calculated values
    */
-  period_cnt = app_letimer_struct->period * LETIMER_HZ;
-  period_active_cnt = app_letimer_struct->active_period * LETIMER_HZ;
+  letimer0_period = app_letimer_struct->period;
+  letimer0_active_period = app_letimer_struct->active_period;
+  period_cnt = letimer0_ticks(letimer0_period) - 1;     // the counter runs COMP0 + 1 ticks per period
+  letimer0_next_period_cnt = period_cnt;
+  period_active_cnt = letimer0_active_cnt(letimer0_active_period);
 
   LETIMER_CompareSet(letimer, 0, period_cnt);           // comp0 register is PWM period
   LETIMER_CompareSet(letimer, 1, period_active_cnt);    // comp1 register is PWM active period
+  letimer0_period_cnt = period_cnt;                     // kept for the letimer_time_ms() time base
+  letimer0_uf_count = 0;
+  letimer0_elapsed_us = 0;
+  letimer0_uf_ticks = 0;
 
   /* Set the REP0 mode bits for PWM operation directly since this driver is PWM specific.
    * Datasheets are very specific and must be read very carefully to implement correct functionality.
@@ -168,6 +216,7 @@ void letimer_pwm_open(LETIMER_TypeDef *letimer, APP_LETIMER_PWM_TypeDef *app_let
        sleep_block_mode(LETIMER_EM);
    }
 
+   letimer0_opened = true;
    NVIC_EnableIRQ(LETIMER0_IRQn);
 
 }
@@ -210,6 +259,231 @@ void letimer_start(LETIMER_TypeDef *letimer, bool enable){
 }
 
 
+/***************************************************************************//**
+ * @brief
+ * Returns the number of underflows (full periods) since the LETIMER was opened
+ *
+ * @param[in] letimer
+ * Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ ******************************************************************************/
+uint32_t letimer_uf_count(LETIMER_TypeDef *letimer){
+  EFM_ASSERT(letimer == LETIMER0);
+  return letimer0_uf_count;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Changes the active period (duty cycle) of the LETIMER PWM outputs
+ *
+ * @details
+ *   The outputs go active when the counter matches COMP1 and go idle on underflow, so COMP1 is the number of ticks
+ *   the outputs are active for each period. Both outputs share COMP1. The value is clamped to the period.
+ *
+ * @note
+ *   The new duty cycle takes effect on the next period. No interrupt is needed to keep the outputs running,
+ *   so the outputs continue in EM2/EM3 with the CPU asleep.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported, the active period
+ *   is kept with the LETIMER0 time base)
+ *
+ * @param[in] active_period
+ *   Desired active period in seconds
+ *
+ ******************************************************************************/
+void letimer_pwm_active_set(LETIMER_TypeDef *letimer, float active_period){
+  EFM_ASSERT(letimer == LETIMER0);
+
+  letimer0_active_period = active_period;
+  LETIMER_CompareSet(letimer, 1, letimer0_active_cnt(active_period));
+  while(letimer->SYNCBUSY);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Applies a measured LETIMER clock frequency
+ *
+ * @details
+ *   The ULFRCO is only specified to a few percent, so LETIMER_HZ is just the starting estimate. The calibration service
+ *   measures the real frequency and passes it here. COMP0 and COMP1 are recomputed from the periods in seconds given to
+ *   letimer_pwm_open() and letimer_pwm_active_set(), and letimer_time_ms() converts ticks with the new frequency.
+ *
+ * @note
+ *   The frequency is applied by the IRQ handler right after the next underflow, which converts the period that just
+ *   ended at the old estimate and writes the new COMP0 and COMP1 there. The COMP0 write then has a whole period to
+ *   synchronize before it is loaded, so the hardware and the time base always agree on the top value of a period,
+ *   which is not the case for a write from thread context that an underflow can land in the middle of.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @param[in] clock_mhz
+ *   Measured LETIMER clock frequency in mHz
+ *
+ ******************************************************************************/
+void letimer_clock_set(LETIMER_TypeDef *letimer, uint32_t clock_mhz){
+  EFM_ASSERT(letimer == LETIMER0);
+  EFM_ASSERT(clock_mhz);
+
+  letimer0_pending_clock_mhz = clock_mhz;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Changes the LETIMER PWM period while it is running
+ *
+ * @details
+ *   COMP0 and COMP1 are recomputed for the new period. A longer period takes effect on the next underflow. A shorter
+ *   period also cuts the period in progress: if more ticks remain than the new period holds, the counter is moved down
+ *   to the new top so the first short period starts now. The ticks already counted in the cut period are added to the
+ *   time base and the calibration tick count, so letimer_time_ms() stays continuous.
+ *
+ * @note
+ *   The counter write takes a couple of ticks to synchronize, which is the only timing error of a change.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @param[in] period
+ *   New period in seconds
+ *
+ ******************************************************************************/
+void letimer_period_set(LETIMER_TypeDef *letimer, float period){
+  uint32_t count;
+
+  EFM_ASSERT(letimer == LETIMER0);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  letimer0_period = period;
+  letimer0_next_period_cnt = letimer0_ticks(period) - 1;
+  LETIMER_CompareSet(letimer, 0, letimer0_next_period_cnt);
+  LETIMER_CompareSet(letimer, 1, letimer0_active_cnt(letimer0_active_period));
+  count = letimer->CNT;
+  if(count > letimer0_next_period_cnt && !(letimer->IF & LETIMER_IF_UF)){
+      letimer0_elapsed_us += letimer0_ticks_us(letimer0_period_cnt - count);
+      letimer0_uf_ticks += letimer0_period_cnt - count;
+      letimer0_period_cnt = letimer0_next_period_cnt;
+      letimer->CNT = letimer0_next_period_cnt;
+  }
+  CORE_EXIT_CRITICAL();
+  while(letimer->SYNCBUSY);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the LETIMER PWM period in seconds
+ ******************************************************************************/
+float letimer_period_get(LETIMER_TypeDef *letimer){
+  EFM_ASSERT(letimer == LETIMER0);
+  return letimer0_period;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the LETIMER clock frequency in mHz used for the compare values and time conversions
+ ******************************************************************************/
+uint32_t letimer_clock_get(LETIMER_TypeDef *letimer){
+  EFM_ASSERT(letimer == LETIMER0);
+  return letimer0_clock_mhz;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Sets a function whose return value is captured in the IRQ handler on every underflow
+ *
+ * @details
+ *   The calibration service passes a read of a counter that runs from a reference clock. Pairing that count with the
+ *   number of LETIMER ticks at the same underflow measures the LETIMER clock without extra interrupts.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @param[in] capture
+ *   Reference counter read, NULL stops the capture
+ *
+ ******************************************************************************/
+void letimer_uf_capture_set(LETIMER_TypeDef *letimer, uint32_t (*capture)(void)){
+  EFM_ASSERT(letimer == LETIMER0);
+  letimer0_uf_capture = capture;
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the tick count and reference count captured on the last underflow
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @param[out] ticks
+ *   LETIMER ticks counted from letimer_pwm_open() to the last underflow, wraps at 32 bits
+ *
+ * @param[out] ref
+ *   Value returned by the capture function at the last underflow
+ *
+ ******************************************************************************/
+void letimer_uf_captured(LETIMER_TypeDef *letimer, uint32_t *ticks, uint32_t *ref){
+  EFM_ASSERT(letimer == LETIMER0);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *ticks = letimer0_uf_ticks;
+  *ref = letimer0_uf_ref;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Returns the number of the last underflow and the time it happened
+ *
+ * @details
+ *   The time is recorded in the IRQ handler on the same time base as letimer_time_ms(), so the delay from an underflow
+ *   to the code it released is letimer_time_ms() minus this time, whatever the clock calibration or period changes did
+ *   to the time base since letimer_pwm_open().
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @param[out] count
+ *   Underflows since letimer_pwm_open(), as letimer_uf_count()
+ *
+ * @param[out] time_ms
+ *   letimer_time_ms() at that underflow
+ *
+ ******************************************************************************/
+void letimer_uf_release(LETIMER_TypeDef *letimer, uint32_t *count, uint32_t *time_ms){
+  EFM_ASSERT(letimer == LETIMER0);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  *count = letimer0_uf_count;
+  *time_ms = letimer0_uf_time_ms;
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Connects or disconnects the LETIMER PWM outputs from their pins
+ *
+ * @details
+ *   Programs the ROUTEPEN register with boolean multiplication in the same way as letimer_pwm_open(). A disconnected
+ *   output leaves the pin at its GPIO value.
+ *
+ * @param[in] letimer
+ *   Pointer to the base peripheral address of the LETIMER peripheral
+ *
+ * @param[in] out0_en
+ *   True to drive the out 0 route from the LETIMER
+ *
+ * @param[in] out1_en
+ *   True to drive the out 1 route from the LETIMER
+ *
+ ******************************************************************************/
+void letimer_out_enable(LETIMER_TypeDef *letimer, bool out0_en, bool out1_en){
+  letimer->ROUTEPEN = (LETIMER_ROUTEPEN_OUT0PEN * out0_en) | (LETIMER_ROUTEPEN_OUT1PEN * out1_en);
+}
+
+
 /***************************************************************************//**
  * @brief
  * This function handles all LETIMER0 interrupts that are triggered
@@ -242,8 +516,69 @@ void LETIMER0_IRQHandler(void){
   }
   if(interrupt_flag & LETIMER_IF_UF){ //UF triggered interrupt
       EFM_ASSERT(!(LETIMER0->IF & LETIMER_IF_UF));
+      if(letimer0_uf_capture){
+          letimer0_uf_ref = letimer0_uf_capture();
+      }
+      letimer0_uf_count++;
+      letimer0_uf_ticks += letimer0_period_cnt + 1;
+      letimer0_elapsed_us += letimer0_ticks_us(letimer0_period_cnt + 1);
+      letimer0_uf_time_ms = (uint32_t)(letimer0_elapsed_us / 1000);
+      letimer0_period_cnt = letimer0_next_period_cnt; //COMP0 was just loaded into the counter
+      if(letimer0_pending_clock_mhz){
+          letimer0_clock_mhz = letimer0_pending_clock_mhz;
+          letimer0_pending_clock_mhz = 0;
+          letimer0_next_period_cnt = letimer0_ticks(letimer0_period) - 1;
+          LETIMER_CompareSet(LETIMER0, 0, letimer0_next_period_cnt); //synchronized long before the next underflow
+          LETIMER_CompareSet(LETIMER0, 1, letimer0_active_cnt(letimer0_active_period));
+      }
       add_scheduled_event(scheduled_uf_cb);
   }
 
 }
 
+/***************************************************************************//**
+ * @brief
+ * Returns the time in milliseconds since the LETIMER was opened
+ *
+ * @details
+ * The time is built from the time of the last underflow plus the ticks counted down within the current period.
+ * If an underflow is pending but has not been serviced yet, it is added here so the time never steps backwards.
+ * Each period is converted at the clock estimate in use when it ended, so a new letimer_clock_set() value does not
+ * move the time of the periods already counted.
+ *
+ * @note
+ * Used to timestamp sensor samples. Requires the underflow interrupt to be enabled, since the periods are counted in the IRQ handler.
+ * Modules opened before the LETIMER0 read 0, the time letimer_pwm_open() starts from, without touching the unclocked
+ * counter.
+ *
+ * @param[in] letimer
+ * Pointer to the base peripheral address of the LETIMER peripheral (only LETIMER0 is supported)
+ *
+ * @return
+ * Milliseconds since letimer_pwm_open(), 0 before it
+ ******************************************************************************/
+uint32_t letimer_time_ms(LETIMER_TypeDef *letimer){
+  uint64_t elapsed_us;
+  uint32_t period_cnt;
+  uint32_t count;
+
+  EFM_ASSERT(letimer == LETIMER0);
+  if(!letimer0_opened){
+      return 0;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  elapsed_us = letimer0_elapsed_us;
+  period_cnt = letimer0_period_cnt;
+  count = letimer->CNT;
+  if(letimer->IF & LETIMER_IF_UF){ //underflow happened but the IRQ has not run yet
+      elapsed_us += letimer0_ticks_us(period_cnt + 1);
+      period_cnt = letimer0_next_period_cnt;
+      count = letimer->CNT;
+  }
+  elapsed_us += letimer0_ticks_us(period_cnt - count);
+  CORE_EXIT_CRITICAL();
+
+  return (uint32_t)(elapsed_us / 1000);
+}
@@ -33,6 +33,9 @@ uint32_t  rx_done_evt;
 uint32_t  tx_done_evt;
 bool    leuart0_tx_busy;
 static LEUART_STATE_MACHINE leuart0_state_machine;
+static uint8_t  rx_ring[LEUART_RX_RING];
+static volatile uint32_t rx_head;       // written by the IRQ
+static volatile uint32_t rx_tail;       // written by leuart_rx_read()
 
 /***************************************************************************//**
  * @brief LEUART driver
@@ -106,6 +109,11 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
     case end:
       //end logic
       leuart_sm->leuart->IEN &= ~LEUART_IEN_TXC;
+      if(leuart_sm->leuart->CTRL & LEUART_CTRL_TXDMAWU){ //transmit was fed by the LDMA
+          while(leuart_sm->leuart->SYNCBUSY);
+          leuart_sm->leuart->CTRL &= ~LEUART_CTRL_TXDMAWU;
+          dma_done(leuart_sm->dma_ch);
+      }
       leuart_sm->state = write_UART;
       leuart_sm->available = true;
       sleep_unblock_mode(LEUART_TX_EM);
@@ -118,6 +126,25 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
   }
 }
 
+/***************************************************************************//**
+ * @brief
+ *   LEUART function that services the RXDATAV interrupt
+ *
+ * @details
+ *   Reading RXDATA clears the interrupt. The byte is kept in the ring until read by leuart_rx_read(), a byte that
+ *   arrives with the ring full is dropped.
+ *
+ ******************************************************************************/
+static void read_data_func(LEUART_TypeDef *leuart){
+  uint8_t data = leuart->RXDATA;
+
+  if(rx_head - rx_tail < LEUART_RX_RING){
+      rx_ring[rx_head % LEUART_RX_RING] = data;
+      rx_head++;
+  }
+  add_scheduled_event(rx_done_evt);
+}
+
 //***********************************************************************************
 // Global functions
 //***********************************************************************************
@@ -128,7 +155,8 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
  *
  * @details
  *  This function enables the LEUART0 clock, routes the tx and rx pins, initializes all the leuart values that are needed for
- *  leuart0 operation, and enables leuart0 interrupts.
+ *  leuart0 operation, and enables leuart0 interrupts. The LDMA channel used by leuart_tx_dma() is taken from the DMA
+ *  service, so dma_open() must have been called.
  *
  * @param[in] *leuart
  *  LEUART peripheral type define (LEUART0)
@@ -140,6 +168,7 @@ static void stop_func(LEUART_STATE_MACHINE *leuart_sm){
 
 void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
   LEUART_Init_TypeDef leuart_values;
+  DMA_CHANNEL_OPEN tx_channel;
 
   // Enables clock
   CMU_ClockEnable(cmuClock_LEUART0, true);
@@ -195,6 +224,18 @@ void leuart_open(LEUART_TypeDef *leuart, LEUART_OPEN_STRUCT *leuart_settings){
   //leuart->IEN |= (LEUART_IEN_TXBL * leuart_settings->txbl_irq_enable);
   //clear all interrupts
   leuart->IFC = _LEUART_IFC_MASK;
+  rx_head = 0;
+  rx_tail = 0;
+  if(rx_done_evt){ //received bytes are only collected when someone services them
+      leuart->IEN |= LEUART_IEN_RXDATAV;
+  }
+
+  // the end of a DMA transmit is taken from TXC, so the channel has no done function or event
+  tx_channel.done_func = NULL;
+  tx_channel.ctx = NULL;
+  tx_channel.done_cb = 0;
+  tx_channel.em_block = LEUART_TX_EM; //TXDMAWU wakes the LDMA in EM2, not below
+  leuart0_state_machine.dma_ch = dma_channel_alloc(&tx_channel);
 
   NVIC_EnableIRQ(LEUART0_IRQn);
 
@@ -245,15 +286,156 @@ void leuart_start(LEUART_TypeDef *leuart, char *string, uint32_t string_len){
 }
 
 
+/***************************************************************************//**
+ * @brief
+ *  Transmits a buffer through the LEUART with the LDMA, without copying it
+ *
+ * @details
+ *  The LDMA writes TXDATA on every TXBL request, so no interrupt is taken per byte and the buffer is not copied into the
+ *  state machine. TXDMAWU lets the LDMA be woken by the LEUART from EM2 for the length of the transfer. The state machine
+ *  starts in the end state, so the TXC interrupt after the last byte finishes the transmit exactly like leuart_start().
+ *
+ * @note
+ *  The channel is the one leuart_open() took from the DMA service. Its done interrupt is not used, the transfer is
+ *  ended with dma_done() when TXC is serviced.
+ *
+ * @param[in] *leuart
+ *  LEUART peripheral type define (LEUART0)
+ *
+ * @param[in] *data
+ *  Bytes to transmit, must stay valid until tx_cb is serviced
+ *
+ * @param[in] length
+ *  Number of bytes, at most DMA_MAX_XFER (one LDMA descriptor)
+ *
+ * @param[in] tx_cb
+ *  Event scheduled when the last byte has left the shift register
+ *
+ ******************************************************************************/
+
+void leuart_tx_dma(LEUART_TypeDef *leuart, const uint8_t *data, uint32_t length, uint32_t tx_cb){
+  EFM_ASSERT(length > 0 && length <= DMA_MAX_XFER);
+  EFM_ASSERT(CMU->HFBUSCLKEN0 & CMU_HFBUSCLKEN0_LDMA);
+
+  while(!leuart0_state_machine.available);
+  while(leuart->SYNCBUSY);
+
+  CORE_DECLARE_IRQ_STATE; //atomic state
+  CORE_ENTER_CRITICAL();
+
+  leuart0_state_machine.available = false;
+  sleep_block_mode(LEUART_TX_EM);
+
+  leuart0_state_machine.leuart = leuart;
+  leuart0_state_machine.length = length;
+  leuart0_state_machine.count = length;
+  leuart0_state_machine.leuart_cb = tx_cb;
+  leuart0_state_machine.state = end;
+
+  leuart->CTRL |= LEUART_CTRL_TXDMAWU;
+  leuart->IFC = LEUART_IFC_TXC;
+  leuart->IEN |= LEUART_IEN_TXC;
+
+  LDMA_TransferCfg_t tx_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_LEUART0_TXBL);
+  DMA_CHAIN tx_chain;
+  dma_chain_init(&tx_chain, &leuart0_state_machine.tx_desc, 1, ldmaCtrlSizeByte);
+  dma_chain_add(&tx_chain, dma_mem_to_periph, data, &leuart->TXDATA, length);
+  leuart0_state_machine.tx_desc.xfer.doneIfs = 0; //completion is taken from TXC, not the LDMA IRQ
+  dma_start(leuart0_state_machine.dma_ch, &tx_cfg, &tx_chain);
+
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ *  Returns whether a transmit is in progress on the LEUART
+ *
+ * @details
+ *  leuart_start() and leuart_tx_dma() wait for the previous transmit to finish. A caller that must not wait checks
+ *  this first.
+ *
+ * @param[in] *leuart
+ *  LEUART peripheral type define (LEUART0)
+ *
+ * @return
+ *  True until the TXC interrupt of the current transmit has been serviced
+ *
+ ******************************************************************************/
+
+bool leuart_tx_busy(LEUART_TypeDef *leuart){
+  EFM_ASSERT(leuart == LEUART0);
+  return !leuart0_state_machine.available;
+}
+
+
+/***************************************************************************//**
+ * @brief
+ *  Copies out the bytes received since the last call
+ *
+ * @details
+ *  Bytes are only received when leuart_open() was given an rx_done_evt, which is scheduled on every byte.
+ *
+ * @param[in] *leuart
+ *  LEUART peripheral type define (LEUART0)
+ *
+ * @param[out] *data
+ *  Received bytes, oldest first
+ *
+ * @param[in] max
+ *  Size of data
+ *
+ * @return
+ *  Number of bytes copied
+ *
+ ******************************************************************************/
+
+uint32_t leuart_rx_read(LEUART_TypeDef *leuart, uint8_t *data, uint32_t max){
+  uint32_t count = 0;
+
+  EFM_ASSERT(leuart == LEUART0);
+  while(count < max && rx_tail != rx_head){
+      data[count++] = rx_ring[rx_tail % LEUART_RX_RING];
+      rx_tail++;
+  }
+  return count;
+}
+
+
+/***************************************************************************//**
+ * @brief
+ *  Enables or disables the RXDATAV interrupt that collects received bytes
+ *
+ * @details
+ *  Disabled around the polled leuart_app_receive_byte() of the TDD test, whose bytes the interrupt would otherwise
+ *  take. It is only enabled if leuart_open() was given an rx_done_evt.
+ *
+ * @param[in] *leuart
+ *  LEUART peripheral type define (LEUART0)
+ *
+ * @param[in] enable
+ *  True to collect received bytes in the ring
+ *
+ ******************************************************************************/
+
+void leuart_rx_irq_enable(LEUART_TypeDef *leuart, bool enable){
+  EFM_ASSERT(leuart == LEUART0);
+  if(enable && rx_done_evt){
+      leuart->IEN |= LEUART_IEN_RXDATAV;
+  }else{
+      leuart->IEN &= ~LEUART_IEN_RXDATAV;
+  }
+}
+
+
 /***************************************************************************//**
  * @brief
  * Interrupt handler for the LEUART0 peripheral
  *
  * @details
- * This function handles the TXBL and TXC interrupts triggered within the leuart0 peripheral. It will call state machine functions to service the interrupt triggered based on its current state.
+ * This function handles the TXBL, TXC and RXDATAV interrupts triggered within the leuart0 peripheral. It will call state machine functions to service the interrupt triggered based on its current state.
  *
  * @note
- * This function will respond and handle the TXBL and TXC interrupts.
+ * This function will respond and handle the TXBL, TXC and RXDATAV interrupts.
  ******************************************************************************/
 
 void LEUART0_IRQHandler(void){
@@ -266,6 +448,9 @@ void LEUART0_IRQHandler(void){
   if(int_flag & LEUART_IF_TXC){ // Transmission completed
       stop_func(&leuart0_state_machine);
   }
+  if(int_flag & LEUART_IF_RXDATAV){ // Byte received, cleared by reading RXDATA
+      read_data_func(LEUART0);
+  }
 }
 
 
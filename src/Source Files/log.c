@@ -0,0 +1,317 @@
+/**
+ * @file
+ * log.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that stores log records as a format id and raw arguments and sends them as binary frames
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "log.h"
+
+//***********************************************************************************
+// defined files
+//***********************************************************************************
+#define LOG_HEADER_VALID      0x80000000          // never 0, so an unwritten header is 0
+#define LOG_HEADER(id, nargs) (LOG_HEADER_VALID | ((uint32_t)(nargs) << 16) | ((id) & 0xFFFF))
+#define LOG_RING_MASK         (LOG_RING_WORDS - 1)
+#define LOG_TIME_SIZE         4
+
+_Static_assert((LOG_RING_WORDS & LOG_RING_MASK) == 0, "LOG_RING_WORDS must be a power of 2");
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static volatile uint32_t log_ring[LOG_RING_WORDS] RAM_RETAINED;
+static volatile uint32_t log_head;                // next word to reserve, written by any context
+static volatile uint32_t log_tail;                // next word to send, written by log_flush() only
+static volatile uint32_t log_dropped;
+static uint32_t  log_dropped_sent;
+static uint8_t   log_frame[FRAME_SIZE(LOG_FRAME_PAYLOAD)] RAM_NORETAIN;
+static bool      log_tx_busy;
+static uint8_t   log_seq;
+static uint32_t  log_tx_done_cb;
+static uint32_t  log_coalesce_ms;
+static uint32_t  log_batch_ms;            // time the batch being sent was started
+static bool      log_batch;               // frames are going out until the ring is empty
+static LOG_STATS log_telemetry;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Reserves space for a record in the ring
+ *
+ * @details
+ * Any context may log, so head is advanced with LDREX/STREX. An interrupt between the two clears the exclusive monitor,
+ * the STREX fails and the reserve is retried with the head the interrupt left.
+ *
+ * @param[out] index
+ * Ring index of the record header
+ *
+ * @return
+ * False if the ring is full, the record is counted as dropped
+ *
+ ******************************************************************************/
+static inline bool log_reserve(uint32_t words, uint32_t *index){
+  uint32_t head;
+
+  do{
+      head = __LDREXW((volatile uint32_t *)&log_head);
+      if(head - log_tail + words > LOG_RING_WORDS){
+          __CLREX();
+          log_dropped++;
+          return false;
+      }
+  }while(__STREXW(head + words, (volatile uint32_t *)&log_head));
+  *index = head;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores the header of a record whose arguments are already in the ring, making it visible to log_flush()
+ ******************************************************************************/
+static inline void log_commit(uint32_t index, uint32_t id, uint32_t nargs){
+  __DMB(); //arguments land before the header
+  log_ring[index & LOG_RING_MASK] = LOG_HEADER(id, nargs);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Appends a little endian value to the frame payload
+ ******************************************************************************/
+static uint32_t log_put(uint8_t *payload, uint32_t offset, uint32_t value, uint32_t size){
+  for(uint32_t i = 0; i < size; i++){
+      payload[offset + i] = (uint8_t)(value >> (8 * i));
+  }
+  return offset + size;
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Clears the ring and saves the event scheduled when a log frame has been sent
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after ble_open(), before anything logs.
+ *
+ * @param[in] tx_done_cb
+ * Event scheduled when a log frame has left the LEUART, serviced with log_tx_done_service()
+ *
+ ******************************************************************************/
+void log_open(uint32_t tx_done_cb){
+  log_head = 0;
+  log_tail = 0;
+  log_dropped = 0;
+  log_dropped_sent = 0;
+  log_tx_busy = false;
+  log_seq = 0;
+  log_tx_done_cb = tx_done_cb;
+  log_coalesce_ms = 0;
+  log_batch_ms = 0;
+  log_batch = false;
+  log_telemetry = (LOG_STATS){0};
+  for(uint32_t i = 0; i < LOG_RING_WORDS; i++){
+      log_ring[i] = 0;
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores a record with no arguments, called through LOG()
+ ******************************************************************************/
+void log_write0(uint32_t id){
+  uint32_t index;
+
+  if(log_reserve(1, &index)){
+      log_commit(index, id, 0);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores a record with one argument, called through LOG()
+ ******************************************************************************/
+void log_write1(uint32_t id, uint32_t a1){
+  uint32_t index;
+
+  if(log_reserve(2, &index)){
+      log_ring[(index + 1) & LOG_RING_MASK] = a1;
+      log_commit(index, id, 1);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores a record with two arguments, called through LOG()
+ ******************************************************************************/
+void log_write2(uint32_t id, uint32_t a1, uint32_t a2){
+  uint32_t index;
+
+  if(log_reserve(3, &index)){
+      log_ring[(index + 1) & LOG_RING_MASK] = a1;
+      log_ring[(index + 2) & LOG_RING_MASK] = a2;
+      log_commit(index, id, 2);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores a record with three arguments, called through LOG()
+ ******************************************************************************/
+void log_write3(uint32_t id, uint32_t a1, uint32_t a2, uint32_t a3){
+  uint32_t index;
+
+  if(log_reserve(4, &index)){
+      log_ring[(index + 1) & LOG_RING_MASK] = a1;
+      log_ring[(index + 2) & LOG_RING_MASK] = a2;
+      log_ring[(index + 3) & LOG_RING_MASK] = a3;
+      log_commit(index, id, 3);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Stores a record with four arguments, called through LOG()
+ ******************************************************************************/
+void log_write4(uint32_t id, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4){
+  uint32_t index;
+
+  if(log_reserve(5, &index)){
+      log_ring[(index + 1) & LOG_RING_MASK] = a1;
+      log_ring[(index + 2) & LOG_RING_MASK] = a2;
+      log_ring[(index + 3) & LOG_RING_MASK] = a3;
+      log_ring[(index + 4) & LOG_RING_MASK] = a4;
+      log_commit(index, id, 4);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends the committed records in a frame
+ *
+ * @details
+ * The payload starts with letimer_time_ms() at the flush, followed by the records as a 16 bit id and the 32 bit
+ * arguments, all little endian. Records lost to a full ring since the last frame are reported by a LOG_ID_DROPPED
+ * record with the count. Records are taken in ring order up to the first one whose header is not stored yet, and their
+ * words are cleared so the slots read as uncommitted the next time around the ring.
+ *
+ * With a coalescing window set by log_coalesce_set(), records are held until the window has passed since the last batch
+ * was started, the ring is LOG_COALESCE_WORDS full or a drop has to be reported. A batch then goes out frame after frame
+ * until the ring is empty.
+ *
+ * @note
+ * This function will be called once every LETIMER0 period and after every log frame. It returns without waiting if a
+ * log frame or any other LEUART transmit is in progress, or while the module is in an AT exchange (ble_at_busy()).
+ *
+ ******************************************************************************/
+void log_flush(void){
+  uint8_t *payload = &log_frame[FRAME_HEADER_SIZE];
+  uint32_t length;
+  uint32_t tail;
+  uint32_t header;
+  uint32_t nargs;
+  uint32_t dropped;
+
+  if(log_tx_busy || leuart_tx_busy(LOG_LEUART) || ble_at_busy()){
+      return;
+  }
+  tail = log_tail;
+  dropped = log_dropped;
+  if(log_ring[tail & LOG_RING_MASK] == 0 && dropped == log_dropped_sent){
+      log_batch = false;
+      return; //nothing committed
+  }
+  if(!log_batch){
+      if(dropped == log_dropped_sent && log_head - tail < LOG_COALESCE_WORDS &&
+         letimer_time_ms(LETIMER0) - log_batch_ms < log_coalesce_ms){
+          return; //held to share a frame with later records
+      }
+      log_batch = true;
+      log_batch_ms = letimer_time_ms(LETIMER0);
+  }
+
+  length = log_put(payload, 0, letimer_time_ms(LETIMER0), LOG_TIME_SIZE);
+  if(dropped != log_dropped_sent){
+      length = log_put(payload, length, LOG_ID_DROPPED, 2);
+      length = log_put(payload, length, dropped - log_dropped_sent, 4);
+      log_dropped_sent = dropped;
+  }
+  while((header = log_ring[tail & LOG_RING_MASK]) != 0){
+      nargs = (header >> 16) & 0xFF;
+      EFM_ASSERT(nargs <= LOG_ARGS_MAX);
+      if(length + 2 + 4 * nargs > LOG_FRAME_PAYLOAD){
+          break; //rest goes in the next frame
+      }
+      length = log_put(payload, length, header, 2);
+      log_ring[tail & LOG_RING_MASK] = 0;
+      for(uint32_t i = 1; i <= nargs; i++){
+          length = log_put(payload, length, log_ring[(tail + i) & LOG_RING_MASK], 4);
+          log_ring[(tail + i) & LOG_RING_MASK] = 0;
+      }
+      tail += 1 + nargs;
+      log_telemetry.records++;
+  }
+  __DMB(); //slots are cleared before producers can reserve them again
+  log_tail = tail;
+
+  length = frame_seal(log_frame, frame_type_log, log_seq++, length);
+  log_tx_busy = true;
+  log_telemetry.frames++;
+  log_telemetry.wire_bytes += length;
+  leuart_tx_dma(LOG_LEUART, log_frame, length, log_tx_done_cb);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets how long records may be held so that fewer, fuller frames are sent
+ *
+ * @details
+ * Each frame costs the radio a wake up and FRAME_SIZE(0) + LOG_TIME_SIZE bytes whatever it carries. A record held in
+ * the ring goes out with the time of its frame, so the window is also how late a record's time can be. 0 sends the
+ * records at the next log_flush(), as before.
+ *
+ * @param[in] window_ms
+ * Longest time from the start of one batch to the start of the next
+ *
+ ******************************************************************************/
+void log_coalesce_set(uint32_t window_ms){
+  log_coalesce_ms = window_ms;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Services the end of a log frame and sends the next one if records are waiting
+ *
+ * @note
+ * This function will be called in app.c each time the tx_done_cb event passed to log_open() is serviced.
+ *
+ ******************************************************************************/
+void log_tx_done_service(void){
+  log_tx_busy = false;
+  log_flush();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the log telemetry
+ *
+ * @param[out] stats
+ * Records sent and dropped, frames and wire bytes
+ *
+ ******************************************************************************/
+void log_stats(LOG_STATS *stats){
+  *stats = log_telemetry;
+  stats->dropped = log_dropped;
+}
@@ -0,0 +1,303 @@
+/**
+ * @file
+ * lttb.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that downsamples a stream of points with Largest-Triangle-Three-Buckets in a single pass
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "lttb.h"
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Cross product of (a - o) and (b - o), positive when o, a, b turn counterclockwise
+ ******************************************************************************/
+static inline int64_t lttb_cross(const LTTB_POINT *o, const LTTB_POINT *a, const LTTB_POINT *b){
+  int32_t ax = (int32_t)(a->timestamp - o->timestamp);   // relative timestamps and values, both fit in 31 bits
+  int32_t ay = a->value - o->value;
+  int32_t bx = (int32_t)(b->timestamp - o->timestamp);
+  int32_t by = b->value - o->value;
+
+  return (int64_t)ax * by - (int64_t)ay * bx;             // two 32x32->64 multiplies (SMULL)
+}
+
+/***************************************************************************//**
+ * @brief
+ * Makes room in a full hull by dropping its oldest interior point
+ ******************************************************************************/
+static void lttb_hull_drop(LTTB_STATE *lttb, LTTB_POINT *hull, uint32_t *count){
+  for(uint32_t i = 1; i < LTTB_HULL_MAX - 1; i++){
+      hull[i] = hull[i + 1];
+  }
+  (*count)--;
+  lttb->hull_drops++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a point to the hulls of a bucket
+ *
+ * @details
+ * Monotone chain: points that no longer turn clockwise are popped from the upper hull, points that no longer turn
+ * counterclockwise from the lower hull. The two sides are written out separately so each loop has a single test.
+ *
+ ******************************************************************************/
+static void lttb_hull_add(LTTB_STATE *lttb, LTTB_BUCKET *bucket, const LTTB_POINT *point){
+  uint32_t count;
+
+  count = bucket->upper_count;
+  while(count >= 2 && lttb_cross(&bucket->upper[count - 2], &bucket->upper[count - 1], point) >= 0){
+      count--;
+  }
+  if(count == LTTB_HULL_MAX){
+      lttb_hull_drop(lttb, bucket->upper, &count);
+  }
+  bucket->upper[count++] = *point;
+  bucket->upper_count = count;
+
+  count = bucket->lower_count;
+  while(count >= 2 && lttb_cross(&bucket->lower[count - 2], &bucket->lower[count - 1], point) <= 0){
+      count--;
+  }
+  if(count == LTTB_HULL_MAX){
+      lttb_hull_drop(lttb, bucket->lower, &count);
+  }
+  bucket->lower[count++] = *point;
+  bucket->lower_count = count;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a point, relative to the origin, to the bucket being read
+ ******************************************************************************/
+static void lttb_bucket_add(LTTB_STATE *lttb, LTTB_BUCKET *bucket, const LTTB_POINT *point){
+  lttb_hull_add(lttb, bucket, point);
+  bucket->sum_t += point->timestamp;
+  bucket->sum_v += point->value;
+  bucket->count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Keeps the point of the held bucket with the largest triangle between the last kept point and next
+ *
+ * @details
+ * Of points with the same area the earliest is kept, as the classic algorithm does scanning in index order. The
+ * earliest of a tie is always on a hull: the area is the absolute value of a linear function, so a tie with the
+ * maximum off the hull vertices means the function is constant along a hull edge, whose earlier end is a vertex.
+ ******************************************************************************/
+static void lttb_select(LTTB_STATE *lttb, const LTTB_POINT *next){
+  LTTB_BUCKET *bucket = &lttb->bucket[lttb->held];
+  const LTTB_POINT *best = &bucket->upper[0];
+  uint64_t best_area = 0;
+  uint64_t area;
+  int64_t cross;
+
+  for(uint32_t i = 0; i < bucket->upper_count; i++){
+      cross = lttb_cross(&lttb->selected, &bucket->upper[i], next);
+      area = cross < 0 ? -cross : cross;
+      if(area > best_area || (area == best_area && bucket->upper[i].timestamp < best->timestamp)){
+          best_area = area;
+          best = &bucket->upper[i];
+      }
+  }
+  for(uint32_t i = 0; i < bucket->lower_count; i++){
+      cross = lttb_cross(&lttb->selected, &bucket->lower[i], next);
+      area = cross < 0 ? -cross : cross;
+      if(area > best_area || (area == best_area && bucket->lower[i].timestamp < best->timestamp)){
+          best_area = area;
+          best = &bucket->lower[i];
+      }
+  }
+  lttb->selected = *best;
+  lttb->out[lttb->out_count].timestamp = best->timestamp + lttb->origin;
+  lttb->out[lttb->out_count].value = best->value;
+  lttb->out_count++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the average point of a bucket, rounded to whole units
+ ******************************************************************************/
+static LTTB_POINT lttb_average(const LTTB_BUCKET *bucket){
+  LTTB_POINT average;
+  int64_t half = bucket->count / 2;
+
+  average.timestamp = (uint32_t)((bucket->sum_t + half) / bucket->count);
+  average.value = (int32_t)((bucket->sum_v + (bucket->sum_v < 0 ? -half : half)) / bucket->count);
+  return average;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the input index of the first point of a bucket
+ *
+ * @details
+ * Bucket b starts at floor(b * (in_points - 2) / (out_points - 2)) + 1, the same split as the published algorithm.
+ * Only called when a bucket starts, so there is no division per point.
+ *
+ ******************************************************************************/
+static uint32_t lttb_bucket_start(LTTB_STATE *lttb, uint32_t bucket){
+  return (uint32_t)((uint64_t)bucket * (lttb->in_points - 2) / (lttb->out_points - 2)) + 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Finishes the bucket being read
+ *
+ * @details
+ * Its average lets the held bucket choose its point, then it becomes the held bucket and an empty one is started.
+ *
+ ******************************************************************************/
+static void lttb_bucket_done(LTTB_STATE *lttb){
+  uint32_t current = lttb->held ^ 1;
+
+  if(lttb->held_valid){
+      LTTB_POINT average = lttb_average(&lttb->bucket[current]);
+      lttb_select(lttb, &average);
+  }
+  lttb->held = current;
+  lttb->held_valid = true;
+  lttb->bucket[current ^ 1] = (LTTB_BUCKET){0};
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Starts a downsampling pass
+ *
+ * @param[out] lttb
+ * Pass state, owned by the caller
+ *
+ * @param[in] in_points
+ * Number of points that will be pushed
+ *
+ * @param[out] out
+ * Array that receives the kept points, in time order
+ *
+ * @param[in] out_points
+ * Number of points to keep, at least 3. If in_points is not larger every point is kept.
+ *
+ ******************************************************************************/
+void lttb_open(LTTB_STATE *lttb, uint32_t in_points, LTTB_POINT *out, uint32_t out_points){
+  EFM_ASSERT(out_points >= 3);
+
+  *lttb = (LTTB_STATE){0};
+  lttb->out = out;
+  lttb->out_points = out_points;
+  lttb->in_points = in_points;
+  lttb->next_bucket = 1;
+  lttb->current_index = (uint32_t)-1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Checks a point against what lttb_push() requires
+ *
+ * @details
+ * Points read from storage are checked with this first, since lttb_push() asserts on a point that breaks the pass.
+ *
+ * @param[in] lttb
+ * Pass opened by lttb_open()
+ *
+ * @param[in] point
+ * Point about to be pushed
+ *
+ * @return
+ * True if the pass still expects a point, the value is inside LTTB_VALUE_MAX, and the point is later than the one
+ * before and within LTTB_SPAN_MAX of the first
+ *
+ ******************************************************************************/
+bool lttb_point_valid(const LTTB_STATE *lttb, const LTTB_POINT *point){
+  if(lttb->in_count >= lttb->in_points){
+      return false;
+  }
+  if(point->value >= LTTB_VALUE_MAX || point->value <= -LTTB_VALUE_MAX){
+      return false;
+  }
+  if(lttb->in_count == 0){
+      return true;
+  }
+  return point->timestamp > lttb->last && point->timestamp - lttb->origin <= LTTB_SPAN_MAX;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Feeds the next point of the input
+ *
+ * @details
+ * Points are kept relative to the first timestamp so every cross product fits in 64 bits.
+ *
+ * @param[in] lttb
+ * Pass opened by lttb_open()
+ *
+ * @param[in] point
+ * Next point, see lttb_point_valid()
+ *
+ ******************************************************************************/
+void lttb_push(LTTB_STATE *lttb, const LTTB_POINT *point){
+  LTTB_POINT relative;
+  uint32_t index;
+
+  EFM_ASSERT(lttb_point_valid(lttb, point));
+  index = lttb->in_count++;
+  if(index == 0){
+      lttb->origin = point->timestamp;
+  }
+  lttb->last = point->timestamp;
+
+  if(lttb->in_points <= lttb->out_points){
+      lttb->out[lttb->out_count++] = *point;
+      return;
+  }
+  if(index == 0){
+      lttb->selected.timestamp = 0;
+      lttb->selected.value = point->value;
+      lttb->out[lttb->out_count++] = *point;
+      return;
+  }
+  relative.timestamp = point->timestamp - lttb->origin;
+  relative.value = point->value;
+
+  if(index == lttb->in_points - 1){
+      lttb_bucket_done(lttb);
+      lttb_select(lttb, &relative);
+      lttb->out[lttb->out_count++] = *point;
+      return;
+  }
+
+  if(index == lttb->next_bucket){
+      if(index > 1){
+          lttb_bucket_done(lttb);
+      }
+      lttb->current_index++;
+      lttb->next_bucket = lttb_bucket_start(lttb, lttb->current_index + 1);
+  }
+  lttb_bucket_add(lttb, &lttb->bucket[lttb->held ^ 1], &relative);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Ends the pass
+ *
+ * @return
+ * Number of points written to the output array, out_points once every input point has been pushed
+ *
+ ******************************************************************************/
+uint32_t lttb_close(LTTB_STATE *lttb){
+  EFM_ASSERT(lttb->in_count == lttb->in_points);
+  return lttb->out_count;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file
+ * mx25.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * This module reads the mx25 SPI flash through the SPI driver
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "mx25.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint8_t  mx25_cmd[MX25_READS_QUEUED][MX25_CMD_BYTES];  //command buffers must live until the read is clocked
+static uint32_t mx25_cmd_next;
+static uint8_t  mx25_single_cmd;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Clocks out a single byte command and waits for it to finish
+ ******************************************************************************/
+static void mx25_command(uint8_t cmd){
+  bool queued = false;
+  SPI_TRANSACTION transaction = {
+    .cs_port = MX25_CS_PORT,
+    .cs_pin  = MX25_CS_PIN,
+    .tx_data = &mx25_single_cmd,
+    .rx_data = NULL,
+    .length  = 1,
+    .hold_cs = false,
+    .spi_cb  = NULL_CB
+  };
+
+  while(!queued){
+      while(!spi_available(MX25_SPI_USART)); //wait for reads in progress to finish
+      mx25_single_cmd = cmd;
+      queued = spi_queue(MX25_SPI_USART, &transaction);   //only fails if a read was queued from an interrupt meanwhile
+  }
+  while(!spi_available(MX25_SPI_USART));
+}
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Opens the SPI bus of the mx25 and wakes the flash
+ *
+ * @details
+ * The flash may have been left in deep power down by the last run, so it is released before it is used.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(). The MX25 pins are configured in gpio_open().
+ *
+ ******************************************************************************/
+void mx25_open(void){
+  SPI_OPEN_STRUCT mx25_spi_open;
+
+  mx25_spi_open.enable = true;
+  mx25_spi_open.refFreq = 0;
+  mx25_spi_open.baudrate = MX25_BAUDRATE;
+  mx25_spi_open.clockMode = usartClockMode0;
+  mx25_spi_open.msbf = true;
+  mx25_spi_open.tx_route = MX25_MOSI_ROUTE;
+  mx25_spi_open.rx_route = MX25_MISO_ROUTE;
+  mx25_spi_open.clk_route = MX25_SCLK_ROUTE;
+  mx25_spi_open.tx_pin_en = true;
+  mx25_spi_open.rx_pin_en = true;
+  mx25_spi_open.clk_pin_en = true;
+
+  spi_open(MX25_SPI_USART, &mx25_spi_open);
+  mx25_cmd_next = 0;
+  mx25_wake();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Releases the flash from deep power down and waits until it can be read
+ ******************************************************************************/
+void mx25_wake(void){
+  mx25_command(MX25_CMD_RELEASE_DPD);
+  timer_delay(MX25_WAKE_DELAY);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts the flash into deep power down, its lowest current state
+ *
+ * @note
+ * mx25_wake() must be called before the next read
+ *
+ ******************************************************************************/
+void mx25_deep_power_down(void){
+  mx25_command(MX25_CMD_DEEP_POWER_DOWN);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Queues a read of the flash straight into the destination buffer
+ *
+ * @details
+ * The read is queued as two SPI transactions in one chip select frame, the command and address from a private buffer
+ * and the data phase received by the LDMA directly into data. Up to MX25_READS_QUEUED reads may be waiting at once.
+ *
+ * @param[in] address
+ * Flash address of the first byte
+ *
+ * @param[out] data
+ * Destination, must stay valid until read_cb is serviced
+ *
+ * @param[in] length
+ * Bytes to read
+ *
+ * @param[in] read_cb
+ * Event scheduled when the data is in the buffer
+ *
+ * @return
+ * False if the SPI queue is full and the read was not queued
+ ******************************************************************************/
+bool mx25_read(uint32_t address, uint8_t *data, uint32_t length, uint32_t read_cb){
+  uint8_t *cmd;
+
+  EFM_ASSERT(address + length <= MX25_SIZE);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  cmd = mx25_cmd[mx25_cmd_next];
+  cmd[0] = MX25_CMD_READ;
+  cmd[1] = (uint8_t)(address >> 16);
+  cmd[2] = (uint8_t)(address >> 8);
+  cmd[3] = (uint8_t)address;
+
+  SPI_TRANSACTION cmd_phase = {
+    .cs_port = MX25_CS_PORT,
+    .cs_pin  = MX25_CS_PIN,
+    .tx_data = cmd,
+    .rx_data = NULL,
+    .length  = MX25_CMD_BYTES,
+    .hold_cs = true,
+    .spi_cb  = NULL_CB
+  };
+  SPI_TRANSACTION data_phase = {
+    .cs_port = MX25_CS_PORT,
+    .cs_pin  = MX25_CS_PIN,
+    .tx_data = NULL,
+    .rx_data = data,
+    .length  = length,
+    .hold_cs = false,
+    .spi_cb  = read_cb
+  };
+
+  if(spi_queue_space(MX25_SPI_USART) < 2){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  spi_queue(MX25_SPI_USART, &cmd_phase);
+  spi_queue(MX25_SPI_USART, &data_phase);
+  mx25_cmd_next = (mx25_cmd_next + 1) % MX25_READS_QUEUED;
+  CORE_EXIT_CRITICAL();
+  return true;
+}
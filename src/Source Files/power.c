@@ -0,0 +1,160 @@
+/**
+ * @file
+ * power.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that switches the DCDC between a low noise and an efficient setting based on activity
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "power.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint32_t     quiet_requests;
+static POWER_STATE  power_state;
+static uint32_t     state_start_ms;
+static POWER_STATS  power_telemetry;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Charges the time since the last change to the current state and moves to the next state
+ *
+ * @note
+ * Must be called from inside a critical section.
+ *
+ ******************************************************************************/
+static void power_state_change(POWER_STATE next){
+  uint32_t now = letimer_time_ms(LETIMER0);
+
+  power_telemetry.state_ms[power_state] += now - state_start_ms;
+  state_start_ms = now;
+  power_state = next;
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Puts the DCDC into its efficient setting and clears the telemetry
+ *
+ * @details
+ * main() initializes the DCDC in low noise mode. Until an analog measurement asks for a quiet supply there is no reason
+ * to pay for fixed frequency switching, so the DCDC is moved to discontinuous conduction right away.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after sleep_open() and before the LETIMER0 is opened.
+ * The state times count from letimer_pwm_open(), letimer_time_ms() reads 0 until then.
+ *
+ ******************************************************************************/
+void power_open(void){
+  quiet_requests = 0;
+  power_state = power_state_efficient;
+  state_start_ms = 0;       // letimer_time_ms() when the LETIMER0 is opened
+  power_telemetry = (POWER_STATS){0};
+  EMU_DCDCConductionModeSet(POWER_EFFICIENT_CONDUCTION, true);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Requests a low noise supply for an analog measurement
+ *
+ * @details
+ * Requests are counted the same way as the sleep blocks, the DCDC is switched on the first request and stays quiet until
+ * every request has been released.
+ *
+ * @note
+ * Called by the sensor module around the trigger of a sensor whose ops table sets quiet_ms. An ADC read would call it
+ * around the conversion the same way.
+ *
+ ******************************************************************************/
+void power_quiet_request(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(quiet_requests++ == 0){
+      EMU_DCDCConductionModeSet(POWER_QUIET_CONDUCTION, true);
+      power_telemetry.quiet_entries++;
+      power_state_change(power_state_quiet);
+  }
+  EFM_ASSERT(quiet_requests < POWER_QUIET_MAX);
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Releases a low noise supply request, the DCDC returns to its efficient setting after the last one
+ *
+ ******************************************************************************/
+void power_quiet_release(void){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  EFM_ASSERT(quiet_requests > 0);
+  if(--quiet_requests == 0){
+      EMU_DCDCConductionModeSet(POWER_EFFICIENT_CONDUCTION, true);
+      power_state_change(power_state_efficient);
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sleep layer hook called right before the processor enters an energy mode
+ *
+ * @details
+ * In EM2/EM3 the DCDC is switched to low power mode by the hardware, so only the time accounting changes here.
+ *
+ * @note
+ * Called by enter_sleep() from inside its critical section.
+ *
+ * @param[in] EM
+ * Energy mode that is about to be entered
+ *
+ ******************************************************************************/
+void power_sleep_enter(uint32_t EM){
+  if(EM >= EM2){
+      power_telemetry.em23_entries++;
+      power_state_change(power_state_em23);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sleep layer hook called right after the processor wakes up, before any interrupt is serviced
+ *
+ * @param[in] EM
+ * Energy mode that was left
+ *
+ ******************************************************************************/
+void power_sleep_exit(uint32_t EM){
+  if(EM >= EM2){
+      power_state_change(quiet_requests ? power_state_quiet : power_state_efficient);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies the transition counters and the time spent in each supply state
+ *
+ * @param[out] stats
+ * Filled with the telemetry, including the time spent in the current state so far
+ *
+ ******************************************************************************/
+void power_stats(POWER_STATS *stats){
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  power_state_change(power_state);
+  *stats = power_telemetry;
+  CORE_EXIT_CRITICAL();
+}
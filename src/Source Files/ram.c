@@ -0,0 +1,53 @@
+/**
+ * @file
+ * ram.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that powers down the RAM blocks the firmware does not use
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "ram.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+extern char __ram_used_end__;     // end of stack, data, bss, noretain and heap, from linkerfile.ld
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Powers down every RAM block above the memory used by the firmware
+ *
+ * @details
+ * The linker script packs the stack, data, bss, noretain buffers and a fixed size heap into the bottom of RAM and
+ * marks the end with __ram_used_end__. Every block that lies completely above that address is powered down, so
+ * it no longer draws retention current in EM2/EM3. The block holding __ram_used_end__ stays powered.
+ *
+ * @note
+ * This function is called once at the start of main(). A powered down block can only be powered up again by a
+ * reset, so nothing may be placed above __ram_used_end__ at run time.
+ *
+ ******************************************************************************/
+void ram_open(void){
+  uint32_t used_end = (uint32_t)&__ram_used_end__;
+
+  EFM_ASSERT(used_end > RAM_MEM_BASE && used_end <= RAM_MEM_BASE + RAM_MEM_SIZE);
+  EMU_RamPowerDown(used_end, 0); //0 powers down every block after used_end
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of bytes of RAM used by the firmware, including stack and heap
+ ******************************************************************************/
+uint32_t ram_used_bytes(void){
+  return (uint32_t)&__ram_used_end__ - RAM_MEM_BASE;
+}
@@ -0,0 +1,389 @@
+/**
+ * @file
+ * replay.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Streams a region of the SPI flash out of the LEUART as frames, without copying the data
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "replay.h"
+#include <string.h>
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static uint8_t          replay_buf[REPLAY_BUFFERS][FRAME_SIZE(REPLAY_PAYLOAD_SIZE)] RAM_NORETAIN;
+static REPLAY_BUF_STATE buf_state[REPLAY_BUFFERS];
+static uint32_t         buf_payload[REPLAY_BUFFERS];
+static uint32_t         fill_idx;
+static uint32_t         drain_idx;
+static uint32_t         next_address;
+static uint32_t         remaining;
+static uint8_t          seq;
+static bool             active;
+static uint32_t         start_ms;
+static uint32_t         replay_fill_cb;
+static uint32_t         replay_drain_cb;
+static uint32_t         replay_done_cb;
+static REPLAY_STATS     replay_telemetry;
+static LTTB_POINT       lttb_out[REPLAY_LTTB_OUT_MAX] RAM_NORETAIN;
+static LTTB_STATE       lttb;
+static bool             history;        // sending lttb_out instead of the flash
+static bool             downsampling;   // reading the flash into the LTTB pass, nothing is sent
+static uint32_t         read_idx;       // buffer the flash read in progress lands in
+static bool             read_pending;
+static bool             history_error;  // a record failed validation, the reads in flight are drained and dropped
+static bool             fill_retry;     // the SPI queue was full, replay_poll() starts the read of fill_retry_idx again
+static uint32_t         fill_retry_idx;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Starts the flash read of the next payload into buffer idx
+ *
+ * @details
+ * The read lands at the payload offset of the frame, so the header and CRC can be written around it in place. If the
+ * SPI queue is full the buffer is left empty and nothing is consumed, replay_poll() tries the read again.
+ *
+ ******************************************************************************/
+static void replay_fill(uint32_t idx){
+  uint32_t length = remaining < REPLAY_PAYLOAD_SIZE ? remaining : REPLAY_PAYLOAD_SIZE;
+
+  if(history && !downsampling){
+      memcpy(&replay_buf[idx][FRAME_HEADER_SIZE], (uint8_t *)lttb_out + next_address, length);
+      add_scheduled_event(replay_fill_cb);  // keeps the fill/drain pipeline identical to a flash read
+  }else{
+      if(!mx25_read(next_address, &replay_buf[idx][FRAME_HEADER_SIZE], length, replay_fill_cb)){
+          replay_telemetry.read_retries++;
+          fill_retry = true;
+          fill_retry_idx = idx;
+          return;
+      }
+      read_idx = idx;
+      read_pending = true;
+  }
+  fill_retry = false;
+  buf_payload[idx] = length;
+  buf_state[idx] = replay_buf_filling;
+  next_address += length;
+  remaining -= length;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Closes out the replay once the last frame has been sent, or a history query once a record failed validation
+ ******************************************************************************/
+static void replay_finish(void){
+  uint64_t capacity;
+
+  replay_telemetry.elapsed_ms = letimer_time_ms(LETIMER0) - start_ms;
+  capacity = (uint64_t)REPLAY_LINK_BAUD * replay_telemetry.elapsed_ms;  // link bits per 1000 s
+  if(capacity){
+      replay_telemetry.link_permille = (uint32_t)((uint64_t)replay_telemetry.wire_bytes * REPLAY_BITS_PER_BYTE * 1000000 / capacity);
+      replay_telemetry.goodput_permille = (uint32_t)((uint64_t)replay_telemetry.payload_bytes * REPLAY_BITS_PER_BYTE * 1000000 / capacity);
+  }
+  active = false;
+  if(!history){
+      mx25_deep_power_down();
+  }
+  add_scheduled_event(replay_done_cb);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Services a flash read of history records while downsampling
+ *
+ * @details
+ * The read of the next payload is started into the other buffer before the records of this one are pushed, so the
+ * LTTB pass runs while the LDMA reads the flash. After the last records the kept points are sent from lttb_out through
+ * the normal fill and drain pipeline.
+ *
+ * The records come from the flash, so each one is checked before it is pushed. An erased slot, a timestamp out of
+ * order or a value the pass cannot hold ends the query: the read in flight is left to land, nothing is sent, and
+ * replay_stats() reports history_error with the index of the record in points_in.
+ *
+ ******************************************************************************/
+static void replay_downsample_service(void){
+  uint32_t idx = read_idx;
+  const uint8_t *record = &replay_buf[idx][FRAME_HEADER_SIZE];
+  LTTB_POINT point;
+
+  read_pending = false;
+  if(remaining && !history_error){
+      replay_fill(idx ^ 1);
+  }
+  for(uint32_t i = 0; i < buf_payload[idx] && !history_error; i += REPLAY_POINT_SIZE){
+      memcpy(&point, &record[i], REPLAY_POINT_SIZE);    // payload is not word aligned, the part is little endian
+      if(point.timestamp == REPLAY_ERASED || !lttb_point_valid(&lttb, &point)){
+          history_error = true;
+          remaining = 0;
+          fill_retry = false;     // a read that was never queued has nothing to land
+      }else{
+          lttb_push(&lttb, &point);
+      }
+  }
+  buf_state[idx] = replay_buf_empty;
+  if(read_pending || fill_retry){
+      return;
+  }
+
+  downsampling = false;
+  if(history_error){
+      replay_telemetry.history_error = true;
+      replay_telemetry.points_in = lttb.in_count;
+      replay_telemetry.downsample_ms = letimer_time_ms(LETIMER0) - start_ms;
+      mx25_deep_power_down();
+      replay_finish();
+      return;
+  }
+  replay_telemetry.points_in = lttb.in_count;
+  replay_telemetry.points_out = lttb_close(&lttb);
+  replay_telemetry.downsample_ms = letimer_time_ms(LETIMER0) - start_ms;
+  mx25_deep_power_down();
+  next_address = 0;
+  remaining = replay_telemetry.points_out * REPLAY_POINT_SIZE;
+  fill_idx = 0;
+  drain_idx = 0;
+  replay_fill(fill_idx);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true if the next buffer is framed and may be sent
+ *
+ * @details
+ * A frame is held while the module is in an AT exchange or booting after AT+RESET, replay_poll() sends it once the
+ * module is free.
+ ******************************************************************************/
+static bool replay_drain_ready(void){
+  return buf_state[drain_idx] == replay_buf_full && !ble_at_busy();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the LEUART transmit of the framed buffer idx
+ ******************************************************************************/
+static void replay_drain(uint32_t idx){
+  uint32_t length = FRAME_SIZE(buf_payload[idx]);
+
+  buf_state[idx] = replay_buf_draining;
+  replay_telemetry.frames++;
+  replay_telemetry.payload_bytes += buf_payload[idx];
+  replay_telemetry.wire_bytes += length;
+  leuart_tx_dma(REPLAY_LEUART, replay_buf[idx], length, replay_drain_cb);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Saves the events that drive the replay pipeline
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after mx25_open() and ble_open().
+ *
+ * @param[in] fill_cb
+ * Event scheduled when a flash read completes, serviced by calling replay_fill_service()
+ *
+ * @param[in] drain_cb
+ * Event scheduled when a frame has been transmitted, serviced by calling replay_drain_service()
+ *
+ * @param[in] done_cb
+ * Event scheduled when the whole region has been sent
+ *
+ ******************************************************************************/
+void replay_open(uint32_t fill_cb, uint32_t drain_cb, uint32_t done_cb){
+  replay_fill_cb = fill_cb;
+  replay_drain_cb = drain_cb;
+  replay_done_cb = done_cb;
+  active = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts streaming a region of the flash
+ *
+ * @details
+ * Each frame carries up to REPLAY_PAYLOAD_SIZE bytes of the region. While one buffer is transmitted by the LDMA from
+ * the LEUART TXBL requests, the next payload is read by the LDMA from the flash into the other buffer, so the link is
+ * never waiting on the flash and the CPU never touches the payload except to compute its CRC.
+ *
+ * @param[in] address
+ * Flash address of the region
+ *
+ * @param[in] length
+ * Bytes to send
+ *
+ * @return
+ * False if a replay is already running
+ ******************************************************************************/
+bool replay_start(uint32_t address, uint32_t length){
+  EFM_ASSERT(length > 0);
+
+  if(active){
+      return false;
+  }
+  active = true;
+  history = false;
+  downsampling = false;
+  fill_retry = false;
+  next_address = address;
+  remaining = length;
+  fill_idx = 0;
+  drain_idx = 0;
+  for(uint32_t i = 0; i < REPLAY_BUFFERS; i++){
+      buf_state[i] = replay_buf_empty;
+  }
+  replay_telemetry = (REPLAY_STATS){0};
+  start_ms = letimer_time_ms(LETIMER0);
+
+  mx25_wake();
+  replay_fill(fill_idx);
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts a downsampled query of history records in the flash
+ *
+ * @details
+ * The region holds points history records of REPLAY_POINT_SIZE bytes in time order. They are read at the SPI rate
+ * and reduced with a single LTTB pass to out_points points, which are then sent as frame_type_history frames. Only
+ * the reduced history goes over the link, and the whole query needs no more RAM than the output array.
+ *
+ * @param[in] address
+ * Flash address of the first record
+ *
+ * @param[in] points
+ * Number of records
+ *
+ * @param[in] out_points
+ * Points to send, 3 to REPLAY_LTTB_OUT_MAX. If there are no more records than this they are all sent.
+ *
+ * @return
+ * False if a replay is already running
+ ******************************************************************************/
+bool replay_start_lttb(uint32_t address, uint32_t points, uint32_t out_points){
+  EFM_ASSERT(points > 0);
+  EFM_ASSERT(out_points >= 3 && out_points <= REPLAY_LTTB_OUT_MAX);
+  EFM_ASSERT(REPLAY_PAYLOAD_SIZE % REPLAY_POINT_SIZE == 0 && sizeof(LTTB_POINT) == REPLAY_POINT_SIZE);
+
+  if(!replay_start(address, points * REPLAY_POINT_SIZE)){
+      return false;
+  }
+  history = true;
+  downsampling = true;
+  history_error = false;
+  lttb_open(&lttb, points, lttb_out, out_points);
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true while a replay is running
+ ******************************************************************************/
+bool replay_active(void){
+  return active;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Services the completion of a flash read
+ *
+ * @details
+ * Frames the payload in place and sends it if the LEUART is free, then starts filling the other buffer if it has
+ * already been sent. During the read phase of a downsampled query the records are pushed into the LTTB pass instead.
+ *
+ * @note
+ * This function will be called in app.c each time the fill_cb event is serviced.
+ *
+ ******************************************************************************/
+void replay_fill_service(void){
+  if(downsampling){
+      replay_downsample_service();
+      return;
+  }
+  frame_seal(replay_buf[fill_idx], history ? frame_type_history : frame_type_replay, seq++, buf_payload[fill_idx]);
+  buf_state[fill_idx] = replay_buf_full;
+  fill_idx = (fill_idx + 1) % REPLAY_BUFFERS;
+
+  if(replay_drain_ready()){
+      replay_drain(drain_idx);
+  }
+  if(remaining && buf_state[fill_idx] == replay_buf_empty){
+      replay_fill(fill_idx);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Services the end of a frame transmit
+ *
+ * @details
+ * Sends the other buffer if it is already framed, and refills the buffer that was just sent. The replay is finished
+ * once the region has been read and every buffer is empty.
+ *
+ * @note
+ * This function will be called in app.c each time the drain_cb event is serviced.
+ *
+ ******************************************************************************/
+void replay_drain_service(void){
+  buf_state[drain_idx] = replay_buf_empty;
+  drain_idx = (drain_idx + 1) % REPLAY_BUFFERS;
+
+  if(replay_drain_ready()){
+      replay_drain(drain_idx);
+  }
+  if(remaining && buf_state[fill_idx] == replay_buf_empty){
+      replay_fill(fill_idx);
+  }
+  if(remaining){
+      return;
+  }
+  for(uint32_t i = 0; i < REPLAY_BUFFERS; i++){
+      if(buf_state[i] != replay_buf_empty){
+          return;
+      }
+  }
+  replay_finish();
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sends a frame that was held while the module was busy with AT commands, and starts again a flash read that found
+ * the SPI queue full
+ *
+ * @note
+ * This function will be called in the LETIMER0 underflow callback, after ble_profile_poll().
+ *
+ ******************************************************************************/
+void replay_poll(void){
+  if(!active){
+      return;
+  }
+  if(fill_retry && buf_state[fill_retry_idx] == replay_buf_empty){
+      replay_fill(fill_retry_idx);
+  }
+  if(replay_drain_ready()){
+      replay_drain(drain_idx);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies the frame and byte counts and the link utilization of the last replay
+ ******************************************************************************/
+void replay_stats(REPLAY_STATS *stats){
+  *stats = replay_telemetry;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file
+ * rules.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Alert rule engine, evaluates compiled rules on every sensor sample and reports only the transitions
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "rules.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+typedef struct {
+  const uint8_t *record;
+  bool          active;
+  bool          holding;          // condition is true, waiting out the hold time
+  uint32_t      since_ms;         // sample time the condition became true
+} RULE_STATE;
+
+typedef struct {
+  int32_t       value[RULES_RATE_POINTS];
+  uint32_t      ms[RULES_RATE_POINTS];
+  uint32_t      head;             // slot of the newest kept sample
+  uint32_t      count;
+} RULE_RATE_BASE;
+
+static RULE_STATE     rule_state[RULES_MAX];
+static uint32_t       rule_count;
+static RULE_RATE_BASE rate_base[SENSOR_MAX];
+static uint32_t       day_offset_ms;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Reads a little endian field of a rule record
+ ******************************************************************************/
+static uint32_t rule_u16(const uint8_t *p){
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static int32_t rule_i32(const uint8_t *p){
+  return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the change of a sensor per minute against its newest kept sample at least RULES_RATE_BASE_MS old
+ *
+ * @details
+ * The sample is kept as a base itself once RULES_RATE_STEP_MS has passed since the last one kept, so the ring always
+ * reaches back past RULES_RATE_BASE_MS once it has filled. The cost is a scan of RULES_RATE_POINTS entries.
+ *
+ * @return
+ * Sensor units per minute, 0 until a base old enough has been kept
+ ******************************************************************************/
+static int32_t rule_rate(RULE_RATE_BASE *base, const SENSOR_SAMPLE *sample){
+  int32_t rate = 0;
+
+  for(uint32_t i = 0; i < base->count; i++){
+      uint32_t slot = (base->head + RULES_RATE_POINTS - i) % RULES_RATE_POINTS;
+      uint32_t age = sample->timestamp - base->ms[slot];
+      if(age >= RULES_RATE_BASE_MS){
+          rate = (int32_t)((int64_t)(sample->value - base->value[slot]) * 60000 / age);
+          break;
+      }
+  }
+  if(base->count == 0 || sample->timestamp - base->ms[base->head] >= RULES_RATE_STEP_MS){
+      base->head = (base->head + 1) % RULES_RATE_POINTS;
+      base->value[base->head] = sample->value;
+      base->ms[base->head] = sample->timestamp;
+      if(base->count < RULES_RATE_POINTS){
+          base->count++;
+      }
+  }
+  return rate;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Checks that a rule record only uses known opcodes and leaves exactly one value on the stack
+ *
+ * @details
+ * Done once when the table is opened, so rule_eval() can run without any bounds checks.
+ *
+ ******************************************************************************/
+static void rule_validate(const uint8_t *record){
+  const uint8_t *op = record + RULE_HEADER_SIZE;
+  const uint8_t *end = record + record[0];
+  int32_t depth = 0;
+
+  EFM_ASSERT(record[0] > RULE_HEADER_SIZE);
+  EFM_ASSERT(record[2] < SENSOR_MAX);
+
+  while(op < end){
+      switch(*op++){
+        case RULE_OP_VALUE:
+        case RULE_OP_RATE:
+          depth++;
+          break;
+        case RULE_OP_CONST:
+          depth++;
+          op += 4;
+          break;
+        case RULE_OP_WINDOW:
+          EFM_ASSERT(rule_u16(op) < RULES_DAY_MIN && rule_u16(op + 2) <= RULES_DAY_MIN);
+          depth++;
+          op += 4;
+          break;
+        case RULE_OP_LT:
+        case RULE_OP_GT:
+        case RULE_OP_LE:
+        case RULE_OP_GE:
+        case RULE_OP_AND:
+        case RULE_OP_OR:
+          EFM_ASSERT(depth >= 2);
+          depth--;
+          break;
+        case RULE_OP_NOT:
+          EFM_ASSERT(depth >= 1);
+          break;
+        default:
+          EFM_ASSERT(false);
+          break;
+      }
+      EFM_ASSERT(depth <= RULES_STACK_DEPTH);
+  }
+  EFM_ASSERT(op == end && depth == 1);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs the condition of a rule on a sample
+ *
+ * @param[in] record
+ * Validated rule record
+ *
+ * @param[in] value
+ * Sample value
+ *
+ * @param[in] rate
+ * Change of the sensor per minute
+ *
+ * @param[in] minute
+ * Minute of the day the sample was taken
+ *
+ * @return
+ * Non zero if the condition is true
+ ******************************************************************************/
+static int32_t rule_eval(const uint8_t *record, int32_t value, int32_t rate, uint32_t minute){
+  int32_t stack[RULES_STACK_DEPTH];
+  int32_t sp = 0;
+  const uint8_t *op = record + RULE_HEADER_SIZE;
+  const uint8_t *end = record + record[0];
+  uint32_t start, stop;
+
+  while(op < end){
+      switch(*op++){
+        case RULE_OP_VALUE:
+          stack[sp++] = value;
+          break;
+        case RULE_OP_RATE:
+          stack[sp++] = rate;
+          break;
+        case RULE_OP_CONST:
+          stack[sp++] = rule_i32(op);
+          op += 4;
+          break;
+        case RULE_OP_WINDOW:
+          start = rule_u16(op);
+          stop = rule_u16(op + 2);
+          op += 4;
+          stack[sp++] = (start <= stop) ? (minute >= start && minute < stop) : (minute >= start || minute < stop);
+          break;
+        case RULE_OP_LT:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] < stack[sp];
+          break;
+        case RULE_OP_GT:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] > stack[sp];
+          break;
+        case RULE_OP_LE:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] <= stack[sp];
+          break;
+        case RULE_OP_GE:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] >= stack[sp];
+          break;
+        case RULE_OP_AND:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] && stack[sp];
+          break;
+        case RULE_OP_OR:
+          sp--;
+          stack[sp - 1] = stack[sp - 1] || stack[sp];
+          break;
+        case RULE_OP_NOT:
+          stack[sp - 1] = !stack[sp - 1];
+          break;
+        default:
+          break;
+      }
+  }
+  return stack[0];
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Loads and validates a compiled rule table
+ *
+ * @details
+ * Every record is checked once here. A malformed table halts on an assert instead of being evaluated.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup() with rules_bytecode from rules_config.c.
+ *
+ * @param[in] bytecode
+ * Rule records back to back, ended by a 0 length byte
+ *
+ ******************************************************************************/
+void rules_open(const uint8_t *bytecode){
+  const uint8_t *record = bytecode;
+
+  rule_count = 0;
+  day_offset_ms = 0;
+  for(uint32_t i = 0; i < SENSOR_MAX; i++){
+      rate_base[i].head = 0;
+      rate_base[i].count = 0;
+  }
+  while(record[0]){
+      EFM_ASSERT(rule_count < RULES_MAX);
+      rule_validate(record);
+      rule_state[rule_count].record = record;
+      rule_state[rule_count].active = false;
+      rule_state[rule_count].holding = false;
+      rule_count++;
+      record += record[0];
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Evaluates every rule of the sample's sensor and returns the rules that changed state
+ *
+ * @details
+ * A rule goes active once its condition has been true for its hold time, and clears on the first sample the condition
+ * is false. The cost is one pass over the rules, each a few dozen opcodes of integer math.
+ *
+ * @note
+ * This function will be called in app.c for every sample collected from the sensor registry.
+ *
+ * @param[in] sample
+ * Sample that was just collected
+ *
+ * @param[out] transitions
+ * Filled with the rules that went active or cleared on this sample
+ *
+ * @param[in] max
+ * Size of transitions
+ *
+ * @return
+ * Number of transitions written
+ ******************************************************************************/
+uint32_t rules_evaluate(const SENSOR_SAMPLE *sample, RULE_TRANSITION *transitions, uint32_t max){
+  uint32_t id = sample->sensor_id;
+  uint32_t count = 0;
+  int32_t rate;
+  uint32_t minute;
+
+  EFM_ASSERT(id < SENSOR_MAX);
+
+  rate = rule_rate(&rate_base[id], sample);
+  minute = ((sample->timestamp + day_offset_ms) / 60000) % RULES_DAY_MIN;
+
+  for(uint32_t i = 0; i < rule_count; i++){
+      RULE_STATE *rule = &rule_state[i];
+      bool changed = false;
+
+      if(rule->record[2] != id){
+          continue;
+      }
+      if(rule_eval(rule->record, sample->value, rate, minute)){
+          if(!rule->holding){
+              rule->holding = true;
+              rule->since_ms = sample->timestamp;
+          }
+          if(!rule->active && sample->timestamp - rule->since_ms >= rule_u16(&rule->record[3]) * 1000){
+              rule->active = true;
+              changed = true;
+          }
+      }else{
+          rule->holding = false;
+          if(rule->active){
+              rule->active = false;
+              changed = true;
+          }
+      }
+      if(changed && count < max){
+          transitions[count].rule_id = rule->record[1];
+          transitions[count].active = rule->active;
+          transitions[count].value = sample->value;
+          transitions[count].timestamp = sample->timestamp;
+          count++;
+      }
+  }
+  return count;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Sets the time of day used by window conditions
+ *
+ * @details
+ * Until this is called the day is counted from boot.
+ *
+ * @param[in] minute
+ * Current minute of the day, 0 to 1439
+ *
+ * @param[in] now_ms
+ * letimer_time_ms() at that minute
+ *
+ ******************************************************************************/
+void rules_time_of_day_set(uint32_t minute, uint32_t now_ms){
+  EFM_ASSERT(minute < RULES_DAY_MIN);
+  day_offset_ms = minute * 60000 + (RULES_DAY_MIN * 60000) - (now_ms % (RULES_DAY_MIN * 60000));
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true if the rule with this id is currently active
+ ******************************************************************************/
+bool rules_active(uint8_t rule_id){
+  for(uint32_t i = 0; i < rule_count; i++){
+      if(rule_state[i].record[1] == rule_id){
+          return rule_state[i].active;
+      }
+  }
+  return false;
+}
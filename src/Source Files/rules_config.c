@@ -0,0 +1,27 @@
+/**
+ * @file
+ * rules_config.c
+ * @brief
+ * Alert rule table, generated by tools/gen_rules.py from rules.cfg.
+ * Do not edit, change the rules file and regenerate.
+ *
+ * 5 rules, 75 bytes
+ */
+
+#include "rules.h"
+
+const uint8_t rules_bytecode[] = {
+  // rule 1, sensor 0, hold 0 s: value < 20 (dark)
+  0x0C, 0x01, 0x00, 0x00, 0x00, 0x01, 0x03, 0x14, 0x00, 0x00, 0x00, 0x04,
+  // rule 2, sensor 0, hold 600 s: value < 20 (dark for more than 10 minutes)
+  0x0C, 0x02, 0x00, 0x58, 0x02, 0x01, 0x03, 0x14, 0x00, 0x00, 0x00, 0x04,
+  // rule 3, sensor 0, hold 0 s: value >= 20 and window 22:00 06:00 (light on during the night)
+  0x12, 0x03, 0x00, 0x00, 0x00, 0x01, 0x03, 0x14, 0x00, 0x00, 0x00, 0x07,
+  0x0B, 0x28, 0x05, 0x68, 0x01, 0x08,
+  // rule 4, sensor 1, hold 300 s: value > 7000 (humid for 5 minutes)
+  0x0C, 0x04, 0x01, 0x2C, 0x01, 0x01, 0x03, 0x58, 0x1B, 0x00, 0x00, 0x05,
+  // rule 5, sensor 2, hold 0 s: rate > 100 or rate < -100 (temperature changing faster than 1 C per minute)
+  0x14, 0x05, 0x02, 0x00, 0x00, 0x02, 0x03, 0x64, 0x00, 0x00, 0x00, 0x05,
+  0x02, 0x03, 0x9C, 0xFF, 0xFF, 0xFF, 0x04, 0x09,
+  0x00  // end of table
+};
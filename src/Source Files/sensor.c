@@ -0,0 +1,358 @@
+/**
+ * @file
+ * sensor.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * This module runs a registry of sensor drivers through a common trigger/collect cycle
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "sensor.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static const SENSOR_OPS *const *sensor_registry;
+static uint32_t sensor_count;
+static uint32_t sensor_collect_cb;
+static uint32_t collect_index;
+static bool     collecting;
+static bool     conversions_pending;
+static uint32_t trigger_time;
+static SENSOR_SAMPLE sensor_cache[SENSOR_MAX];
+static bool     cache_valid[SENSOR_MAX];
+static uint32_t waiter_cbs[SENSOR_MAX];       // events of the callers waiting on the next collect
+static uint32_t waiter_count[SENSOR_MAX];
+static uint32_t sample_readers[SENSOR_MAX];   // requests served by the cached sample, the first one paid for it
+static SENSOR_CACHE_STATS cache_telemetry;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Starts a conversion on every sensor in the registry
+ *
+ * @details
+ * All triggers are issued back to back so that every sensor converts in parallel during the same wake. The time of the
+ * trigger is saved and used as the timestamp of all the samples collected from these conversions.
+ *
+ * @note
+ * Entries with a NULL trigger are started by another entry (ex. si7021 temperature is measured with the humidity).
+ * An entry with quiet_ms set is triggered with the DCDC in low noise mode, and the processor waits in EM0 for quiet_ms
+ * so the trigger write and the conversion both see the quiet supply. The DCDC is back in its efficient setting before
+ * the next entry is triggered. Waiting in EM2 instead would gain nothing, the DCDC is in low power mode there.
+ *
+ ******************************************************************************/
+static void sensor_trigger_all(void){
+  trigger_time = letimer_time_ms(LETIMER0);
+  for(uint32_t i = 0; i < sensor_count; i++){
+      if(!sensor_registry[i]->trigger){
+          continue;
+      }
+      if(sensor_registry[i]->quiet_ms){
+          power_quiet_request();
+          sensor_registry[i]->trigger();
+          timer_delay(sensor_registry[i]->quiet_ms);
+          power_quiet_release();
+      }else{
+          sensor_registry[i]->trigger();
+      }
+  }
+  conversions_pending = true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the read of the sensor at collect_index
+ *
+ ******************************************************************************/
+static void sensor_collect_start(void){
+  collecting = true;
+  sensor_registry[collect_index]->collect(sensor_collect_cb);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the registry index of a sensor id
+ ******************************************************************************/
+static uint32_t sensor_index(uint32_t sensor_id){
+  uint32_t i;
+
+  for(i = 0; i < sensor_count; i++){
+      if(sensor_registry[i]->sensor_id == sensor_id){
+          break;
+      }
+  }
+  EFM_ASSERT(i < sensor_count);
+  return i;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the i2c transactions a consumer would need to read a sensor on its own, a trigger write and a result read
+ ******************************************************************************/
+static uint32_t sensor_read_cost(uint32_t index){
+  return sensor_registry[index]->trigger ? 2 : 1;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Saves a collected sample in the cache and releases the callers waiting on it
+ *
+ * @details
+ * The waiting callers' events are scheduled together, a caller that asked more than once is released once. The
+ * waiters become the first readers of the new sample.
+ *
+ ******************************************************************************/
+static void sensor_cache_fill(uint32_t index, SENSOR_SAMPLE *sample){
+  sensor_cache[index] = *sample;
+  cache_valid[index] = true;
+  sample_readers[index] = waiter_count[index];
+  if(waiter_cbs[index]){
+      add_scheduled_event(waiter_cbs[index]);
+      if(waiter_count[index] > 1){
+          cache_telemetry.shared_collects++;
+      }
+      waiter_cbs[index] = 0;
+      waiter_count[index] = 0;
+  }
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Opens every sensor driver in the registry
+ *
+ * @details
+ * Saves the registry that the app built and calls each driver's open function in registry order. Drivers that share a bus
+ * must be placed after the driver that opens the bus.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after the scheduler and sleep routines are opened.
+ *
+ * @param[in] registry
+ * Array of pointers to the driver ops tables
+ *
+ * @param[in] count
+ * Number of drivers in the registry
+ *
+ * @param[in] collect_cb
+ * Event scheduled every time a single sensor has finished being collected
+ *
+ ******************************************************************************/
+void sensor_open(const SENSOR_OPS *const *registry, uint32_t count, uint32_t collect_cb){
+  EFM_ASSERT(count <= SENSOR_MAX);
+
+  sensor_registry = registry;
+  sensor_count = count;
+  sensor_collect_cb = collect_cb;
+  collect_index = 0;
+  collecting = false;
+  conversions_pending = false;
+  cache_telemetry = (SENSOR_CACHE_STATS){0};
+
+  for(uint32_t i = 0; i < sensor_count; i++){
+      cache_valid[i] = false;
+      waiter_cbs[i] = 0;
+      waiter_count[i] = 0;
+      sample_readers[i] = 0;
+      EFM_ASSERT(sensor_registry[i]->collect && sensor_registry[i]->result);
+      if(sensor_registry[i]->open){
+          sensor_registry[i]->open();
+      }
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Runs one sample cycle of all the sensors
+ *
+ * @details
+ * The cycle is pipelined on a single timer wake. If conversions were triggered on the last call, their results are
+ * collected one sensor at a time, each read starting as soon as the previous one completes. Once the last result is in,
+ * the next conversions are triggered, so the sensors convert while the processor sleeps until the next call.
+ * Adding sensors adds i2c transactions but no timer wakeups.
+ *
+ * @note
+ * This function will be called in the LETIMER0 underflow callback. Samples are handed out through sensor_collect_service().
+ *
+ ******************************************************************************/
+void sensor_sample_all(void){
+  if(collecting || sensor_count == 0){
+      return; //last cycle has not finished collecting, skip this one
+  }
+  if(conversions_pending){
+      collect_index = 0;
+      sensor_collect_start();
+  }else{
+      sensor_trigger_all();
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Services the completion of a single sensor collect
+ *
+ * @details
+ * Converts the collected data of the current sensor into a sample, then moves on to the next sensor in the registry.
+ * After the last sensor, the next set of conversions are triggered.
+ *
+ * @note
+ * This function will be called in app.c each time the collect_cb event passed to sensor_open() is serviced.
+ *
+ * @param[out] sample
+ * Filled with the sensor id, unit, value and trigger timestamp of the collected sensor
+ *
+ * @return
+ * True if a sample was produced
+ *
+ ******************************************************************************/
+bool sensor_collect_service(SENSOR_SAMPLE *sample){
+  const SENSOR_OPS *ops;
+
+  if(!collecting){
+      return false;
+  }
+  ops = sensor_registry[collect_index];
+  sample->sensor_id = ops->sensor_id;
+  sample->unit = ops->unit;
+  sample->value = ops->result();
+  sample->timestamp = trigger_time;
+  sensor_cache_fill(collect_index, sample);
+
+  collect_index++;
+  if(collect_index < sensor_count){
+      sensor_collect_start();
+  }else{
+      collecting = false;
+      conversions_pending = false;
+      sensor_trigger_all();
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Puts every sensor in the registry into its lowest power state
+ *
+ * @note
+ * Sensors that go idle on their own after a conversion have a NULL power_down and are skipped.
+ *
+ ******************************************************************************/
+void sensor_power_down_all(void){
+  for(uint32_t i = 0; i < sensor_count; i++){
+      if(sensor_registry[i]->power_down){
+          sensor_registry[i]->power_down();
+      }
+  }
+  conversions_pending = false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Reads a sensor through the cache
+ *
+ * @details
+ * If the cached sample of the sensor was triggered no more than max_age_ms ago it is copied out and true is returned.
+ * Otherwise ready_cb is scheduled when the sensor is next collected and false is returned. The sample cycle always has
+ * a conversion in progress, so a miss costs no extra i2c transactions and all the misses on a sensor within one
+ * conversion window are released by the same collect. Only when the cycle is stopped are the conversions triggered
+ * here, to be collected by the next sensor_sample_all().
+ *
+ * A request counts as saved only when it shares a sample with an earlier request, either a hit on a sample that was
+ * already handed out or a miss that joins the waiters of the same collect. The first request on a sample is the one a
+ * consumer would have paid for on its own.
+ *
+ * @note
+ * A sample is timestamped when its conversion was triggered, one sample period before it is collected, so the newest
+ * sample is always at least that old. A caller released by ready_cb should take the sample with sensor_cached() rather
+ * than calling sensor_read() with the same age again.
+ *
+ * @param[in] sensor_id
+ * Id of a sensor in the registry
+ *
+ * @param[in] max_age_ms
+ * Oldest sample the caller accepts, ms since its conversion was triggered
+ *
+ * @param[in] ready_cb
+ * Event scheduled once a new sample of the sensor is in the cache
+ *
+ * @param[out] sample
+ * Filled on a cache hit
+ *
+ * @return
+ * True on a cache hit
+ *
+ ******************************************************************************/
+bool sensor_read(uint32_t sensor_id, uint32_t max_age_ms, uint32_t ready_cb, SENSOR_SAMPLE *sample){
+  uint32_t index = sensor_index(sensor_id);
+
+  cache_telemetry.requests++;
+  if(cache_valid[index] && letimer_time_ms(LETIMER0) - sensor_cache[index].timestamp <= max_age_ms){
+      *sample = sensor_cache[index];
+      cache_telemetry.hits++;
+      if(sample_readers[index]++){
+          cache_telemetry.saved += sensor_read_cost(index);
+      }
+      return true;
+  }
+
+  waiter_cbs[index] |= ready_cb;
+  waiter_count[index]++;
+  cache_telemetry.waiters++;
+  if(waiter_count[index] > 1){
+      cache_telemetry.saved += sensor_read_cost(index);
+  }
+  if(!conversions_pending && !collecting){
+      sensor_trigger_all();
+      cache_telemetry.triggers++;
+  }
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the newest sample of a sensor regardless of its age
+ *
+ * @param[in] sensor_id
+ * Id of a sensor in the registry
+ *
+ * @param[out] sample
+ * Newest collected sample
+ *
+ * @return
+ * False if the sensor has not been collected yet
+ *
+ ******************************************************************************/
+bool sensor_cached(uint32_t sensor_id, SENSOR_SAMPLE *sample){
+  uint32_t index = sensor_index(sensor_id);
+
+  if(!cache_valid[index]){
+      return false;
+  }
+  *sample = sensor_cache[index];
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the cache telemetry
+ *
+ * @param[out] stats
+ * Request, hit and waiter counts, the hit rate and the i2c transactions saved
+ *
+ ******************************************************************************/
+void sensor_cache_stats(SENSOR_CACHE_STATS *stats){
+  *stats = cache_telemetry;
+  stats->hit_permille = cache_telemetry.requests ? cache_telemetry.hits * 1000 / cache_telemetry.requests : 0;
+}
@@ -37,6 +37,7 @@
 // Include files
 //***********************************************************************************
 #include "sleep_routines.h"
+#include "power.h"
 
 
 
@@ -136,15 +137,21 @@ void enter_sleep(void){
       CORE_EXIT_CRITICAL(); //Restores interrupt processes
       return;
   }else if(lowest_energy_modes[EM2] > 0){
+      power_sleep_enter(EM1);
       EMU_EnterEM1();
+      power_sleep_exit(EM1);
       CORE_EXIT_CRITICAL(); //Restores interrupt processes
       return;
   }else if(lowest_energy_modes[EM3] > 0){
+      power_sleep_enter(EM2);
       EMU_EnterEM2(true);
+      power_sleep_exit(EM2);
       CORE_EXIT_CRITICAL(); //Restores interrupt processes
       return;
   }else{
+      power_sleep_enter(EM3);
       EMU_EnterEM3(true);
+      power_sleep_exit(EM3);
       CORE_EXIT_CRITICAL(); //Restores interrupt processes
       return;
   }
@@ -0,0 +1,309 @@
+/**
+ * @file
+ * spi.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * This module configures a USART as an SPI master and moves queued transactions with the LDMA
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "spi.h"
+
+//***********************************************************************************
+// Private Variables
+//***********************************************************************************
+static SPI_STATE_MACHINE spi0_state, spi1_state, spi2_state;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Returns the state machine of the USART
+ *
+ ******************************************************************************/
+static SPI_STATE_MACHINE *spi_state_get(USART_TypeDef *usart){
+  if(usart == USART0){
+      return &spi0_state;
+  }else if(usart == USART1){
+      return &spi1_state;
+  }else if(usart == USART2){
+      return &spi2_state;
+  }
+  EFM_ASSERT(false);
+  return 0;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the LDMA transfer of the next chunk of the head transaction
+ *
+ * @details
+ * The RX channel is started before the TX channel so no received byte is missed. A transaction without tx data clocks out
+ * the dummy byte without incrementing the source, and a transaction without rx data drains RXDATA into the dummy byte.
+ * Only the RX channel raises a done interrupt, since the last byte is not received until it has been fully clocked out.
+ * Both channels are started through the DMA service, the RX channel holds SPI_EM_BLOCK while it runs.
+ *
+ ******************************************************************************/
+static void spi_chunk_start(SPI_STATE_MACHINE *spi_sm){
+  SPI_TRANSACTION *transaction = &spi_sm->queue[spi_sm->head];
+  uint32_t chunk = transaction->length - spi_sm->offset;
+
+  if(chunk > SPI_LDMA_MAX_XFER){
+      chunk = SPI_LDMA_MAX_XFER;
+  }
+  spi_sm->chunk = chunk;
+
+  const void *tx_src = transaction->tx_data ? (const void *)(transaction->tx_data + spi_sm->offset) : (const void *)&spi_sm->dummy;
+  void *rx_dst = transaction->rx_data ? (void *)(transaction->rx_data + spi_sm->offset) : (void *)&spi_sm->dummy;
+
+  LDMA_TransferCfg_t tx_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(spi_sm->tx_signal);
+  LDMA_TransferCfg_t rx_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(spi_sm->rx_signal);
+  DMA_CHAIN tx_chain, rx_chain;
+
+  dma_chain_init(&tx_chain, &spi_sm->tx_desc, 1, ldmaCtrlSizeByte);
+  dma_chain_init(&rx_chain, &spi_sm->rx_desc, 1, ldmaCtrlSizeByte);
+  dma_chain_add(&tx_chain, dma_mem_to_periph, tx_src, &spi_sm->usart->TXDATA, chunk);
+  dma_chain_add(&rx_chain, dma_periph_to_mem, &spi_sm->usart->RXDATA, rx_dst, chunk);
+
+  if(!transaction->tx_data){
+      spi_sm->tx_desc.xfer.srcInc = ldmaCtrlSrcIncNone;
+  }
+  if(!transaction->rx_data){
+      spi_sm->rx_desc.xfer.dstInc = ldmaCtrlDstIncNone;
+  }
+  spi_sm->tx_desc.xfer.doneIfs = 0; //ended with dma_done() from the RX done
+
+  dma_start(spi_sm->ldma_rx_ch, &rx_cfg, &rx_chain);
+  dma_start(spi_sm->ldma_tx_ch, &tx_cfg, &tx_chain);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Starts the transaction at the head of the queue
+ *
+ * @details
+ * If the queue is empty the USART is marked available. Otherwise chip select is driven low and the first chunk is
+ * started.
+ *
+ * @note
+ * Called from spi_queue() when the USART is idle, and from the LDMA IRQ when a transaction completes
+ *
+ ******************************************************************************/
+static void spi_next(SPI_STATE_MACHINE *spi_sm){
+  if(spi_sm->count == 0){
+      spi_sm->available = true;
+      return;
+  }
+  spi_sm->offset = 0;
+  GPIO_PinOutClear(spi_sm->queue[spi_sm->head].cs_port, spi_sm->queue[spi_sm->head].cs_pin);
+  spi_chunk_start(spi_sm);
+}
+
+/***************************************************************************//**
+ * @brief
+ * This state machine function services the RX LDMA channel done interrupt
+ *
+ * @details
+ * Called by the DMA service from the LDMA IRQ with the state machine of the USART. The TX channel finished before the
+ * last byte was received, so it is ended here. Starts the next chunk if the transaction is longer than one LDMA
+ * transfer. Once every byte has been received the chip select is released (unless the transaction holds it for the next
+ * one), the completion event is scheduled and the next transaction in the queue is started.
+ *
+ ******************************************************************************/
+static void spi_rx_done(void *ctx){
+  SPI_STATE_MACHINE *spi_sm = ctx;
+  SPI_TRANSACTION *transaction = &spi_sm->queue[spi_sm->head];
+
+  EFM_ASSERT(!spi_sm->available);
+  dma_done(spi_sm->ldma_tx_ch);
+  spi_sm->offset += spi_sm->chunk;
+  spi_sm->bytes += spi_sm->chunk;
+  if(spi_sm->offset < transaction->length){
+      spi_chunk_start(spi_sm);
+      return;
+  }
+  if(!transaction->hold_cs){
+      GPIO_PinOutSet(transaction->cs_port, transaction->cs_pin);
+  }
+  add_scheduled_event(transaction->spi_cb);
+  spi_sm->transactions++;
+  spi_sm->head = (spi_sm->head + 1) % SPI_QUEUE_SIZE;
+  spi_sm->count--;
+  spi_next(spi_sm);
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+
+/***************************************************************************//**
+ * @brief
+ * Initializes a USART as a synchronous SPI master
+ *
+ * @details
+ * This function enables the USART clock, initializes the USART in synchronous master mode, routes the MOSI, MISO and CLK
+ * signals, and takes the two LDMA channels that will move the data from the DMA service.
+ *
+ * @note
+ * Chip select pins are driven by this driver through GPIO and must be configured as push pull outputs, idle high,
+ * in gpio_open(). dma_open() must have been called.
+ *
+ * @param[in] usart
+ * A pointer/address to the desired USART peripheral to be initialized
+ *
+ * @param[in] spi_setup
+ * A struct that contains all the device specific values for initialization
+ ******************************************************************************/
+void spi_open(USART_TypeDef *usart, SPI_OPEN_STRUCT *spi_setup){
+  USART_InitSync_TypeDef usart_values = USART_INITSYNC_DEFAULT;
+  SPI_STATE_MACHINE *spi_sm = spi_state_get(usart);
+  DMA_CHANNEL_OPEN rx_channel, tx_channel;
+
+  // Enables clock
+  if(usart == USART0){
+      CMU_ClockEnable(cmuClock_USART0, true);
+      spi_sm->tx_signal = ldmaPeripheralSignal_USART0_TXBL;
+      spi_sm->rx_signal = ldmaPeripheralSignal_USART0_RXDATAV;
+  }else if(usart == USART1){
+      CMU_ClockEnable(cmuClock_USART1, true);
+      spi_sm->tx_signal = ldmaPeripheralSignal_USART1_TXBL;
+      spi_sm->rx_signal = ldmaPeripheralSignal_USART1_RXDATAV;
+  }else if(usart == USART2){
+      CMU_ClockEnable(cmuClock_USART2, true);
+      spi_sm->tx_signal = ldmaPeripheralSignal_USART2_TXBL;
+      spi_sm->rx_signal = ldmaPeripheralSignal_USART2_RXDATAV;
+  }
+
+  // Test clock operation
+  usart->IFS = USART_IFS_CCF;
+  EFM_ASSERT(usart->IF & USART_IF_CCF);
+  usart->IFC = USART_IFC_CCF;
+  EFM_ASSERT(!(usart->IF & USART_IF_CCF));
+
+  // Set initial usart values for INIT
+  usart_values.enable = usartDisable;
+  usart_values.refFreq = spi_setup->refFreq;
+  usart_values.baudrate = spi_setup->baudrate;
+  usart_values.master = true;
+  usart_values.msbf = spi_setup->msbf;
+  usart_values.clockMode = spi_setup->clockMode;
+
+  USART_InitSync(usart, &usart_values);
+
+  // Route USARTx to desired location
+  usart->ROUTELOC0 = spi_setup->tx_route | spi_setup->rx_route;
+  usart->ROUTELOC1 = spi_setup->clk_route;
+
+  usart->ROUTEPEN |= (USART_ROUTEPEN_TXPEN * spi_setup->tx_pin_en);
+  usart->ROUTEPEN |= (USART_ROUTEPEN_RXPEN * spi_setup->rx_pin_en);
+  usart->ROUTEPEN |= (USART_ROUTEPEN_CLKPEN * spi_setup->clk_pin_en);
+
+  usart->CMD = USART_CMD_CLEARRX | USART_CMD_CLEARTX;
+
+  // RX done drives the state machine and keeps the USART clocked, TX is ended with it
+  rx_channel.done_func = spi_rx_done;
+  rx_channel.ctx = spi_sm;
+  rx_channel.done_cb = 0;
+  rx_channel.em_block = SPI_EM_BLOCK;
+  tx_channel.done_func = NULL;
+  tx_channel.ctx = NULL;
+  tx_channel.done_cb = 0;
+  tx_channel.em_block = DMA_EM_NONE;
+
+  spi_sm->usart = usart;
+  spi_sm->ldma_rx_ch = dma_channel_alloc(&rx_channel);
+  spi_sm->ldma_tx_ch = dma_channel_alloc(&tx_channel);
+  spi_sm->dummy = SPI_DUMMY_BYTE;
+  spi_sm->head = 0;
+  spi_sm->count = 0;
+  spi_sm->bytes = 0;
+  spi_sm->transactions = 0;
+  spi_sm->available = true;
+
+  if(spi_setup->enable){
+      USART_Enable(usart, usartEnable);
+  }
+}
+
+/***************************************************************************//**
+ * @brief
+ * Adds a transaction to the USART queue
+ *
+ * @details
+ * The transaction is copied into the queue, so the struct may live on the stack, but the tx and rx buffers must stay
+ * valid until its completion event is serviced. If the USART is idle the transaction is started right away, the RX
+ * channel blocks the energy mode from then until the queue empties.
+ *
+ * @note
+ * Consecutive transactions with hold_cs set on all but the last are clocked as a single chip select frame, which is how
+ * a command phase and a data phase are split into separate buffers.
+ *
+ * @param[in] usart
+ * A pointer/address to the SPI USART
+ *
+ * @param[in] transaction
+ * Chip select, buffers, length and completion event of the transaction
+ *
+ * @return
+ * False if the queue is full and the transaction was not added
+ ******************************************************************************/
+bool spi_queue(USART_TypeDef *usart, const SPI_TRANSACTION *transaction){
+  SPI_STATE_MACHINE *spi_sm = spi_state_get(usart);
+
+  EFM_ASSERT(transaction->length > 0);
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if(spi_sm->count == SPI_QUEUE_SIZE){
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+  spi_sm->queue[(spi_sm->head + spi_sm->count) % SPI_QUEUE_SIZE] = *transaction;
+  spi_sm->count++;
+  if(spi_sm->available){
+      spi_sm->available = false;
+      spi_next(spi_sm);
+  }
+  CORE_EXIT_CRITICAL();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns true if the USART has no queued or active transactions
+ ******************************************************************************/
+bool spi_available(USART_TypeDef *usart){
+  return spi_state_get(usart)->available;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of transactions that can still be added to the USART queue
+ ******************************************************************************/
+uint32_t spi_queue_space(USART_TypeDef *usart){
+  return SPI_QUEUE_SIZE - spi_state_get(usart)->count;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of bytes clocked by the USART since spi_open()
+ ******************************************************************************/
+uint32_t spi_bytes_transferred(USART_TypeDef *usart){
+  return spi_state_get(usart)->bytes;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Returns the number of transactions completed by the USART since spi_open()
+ ******************************************************************************/
+uint32_t spi_transactions_completed(USART_TypeDef *usart){
+  return spi_state_get(usart)->transactions;
+}
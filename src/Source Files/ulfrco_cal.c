@@ -0,0 +1,165 @@
+/**
+ * @file
+ * ulfrco_cal.c
+ * @author
+ * Adam Vitti
+ * @date
+ * 10/18/26
+ * @brief
+ * Module that measures the ULFRCO against the LFXO and corrects the LETIMER0 timing
+ *
+ */
+
+//***********************************************************************************
+// Include files
+//***********************************************************************************
+#include "ulfrco_cal.h"
+
+//***********************************************************************************
+// Private variables
+//***********************************************************************************
+static bool             window_started;
+static uint32_t         window_ticks;
+static uint32_t         window_ref;
+static ULFRCO_CAL_STATS cal_telemetry;
+
+//***********************************************************************************
+// Private functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Returns the CRYOTIMER count
+ *
+ * @details
+ * The counter runs in the LFXO domain, it is read until two reads agree so a read during an increment is not used.
+ *
+ * @note
+ * Called from the LETIMER0 IRQ handler on every underflow.
+ *
+ ******************************************************************************/
+static uint32_t ulfrco_cal_ref_count(void){
+  uint32_t count;
+
+  do{
+      count = CRYOTIMER_CounterGet();
+  }while(count != CRYOTIMER_CounterGet());
+  return count;
+}
+
+
+//***********************************************************************************
+// Global functions
+//***********************************************************************************
+/***************************************************************************//**
+ * @brief
+ * Starts the CRYOTIMER from the LFXO and captures it on every LETIMER0 underflow
+ *
+ * @details
+ * The CRYOTIMER free runs over its full 32 bit range with no interrupts. EM3 is blocked so the LFXO keeps running.
+ *
+ * @note
+ * This function will be called once in app_peripheral_setup(), after cmu_open() has started the LFXO and before the
+ * LETIMER0 is started.
+ *
+ ******************************************************************************/
+void ulfrco_cal_open(void){
+  CRYOTIMER_Init_TypeDef cryotimer_init = CRYOTIMER_INIT_DEFAULT;
+
+  CMU_ClockEnable(cmuClock_CRYOTIMER, true);
+  cryotimer_init.osc = cryotimerOscLFXO;
+  cryotimer_init.presc = cryotimerPresc_1;
+  cryotimer_init.period = cryotimerPeriod_4294M;
+  cryotimer_init.em4Wakeup = false;
+  cryotimer_init.enable = true;
+  CRYOTIMER_Init(&cryotimer_init);
+
+  window_started = false;
+  cal_telemetry = (ULFRCO_CAL_STATS){0};
+  cal_telemetry.clock_mhz = letimer_clock_get(LETIMER0);
+
+  sleep_block_mode(ULFRCO_CAL_EM);
+  letimer_uf_capture_set(LETIMER0, ulfrco_cal_ref_count);
+}
+
+/***************************************************************************//**
+ * @brief
+ * Closes the measurement window once it is long enough and applies the result
+ *
+ * @details
+ * Reads the LETIMER tick count and reference count captured at the last underflow. The first call opens the window.
+ * Once ULFRCO_CAL_WINDOW_TICKS have been counted, the ULFRCO frequency is computed from the two counts and passed to
+ * letimer_clock_set(), and the next window starts at the same underflow so no time is left unmeasured.
+ *
+ * @note
+ * This function will be called on every LETIMER0 underflow callback, or after every cyclic executive frame. Calling it
+ * more often is harmless, the window only advances on underflows.
+ *
+ ******************************************************************************/
+void ulfrco_cal_service(void){
+  uint32_t ticks;
+  uint32_t ref;
+  uint32_t d_ticks;
+  uint32_t d_ref;
+  uint32_t clock_mhz;
+  uint32_t current_mhz;
+  int32_t  step_ppm;
+  uint32_t step_abs;
+
+  letimer_uf_captured(LETIMER0, &ticks, &ref);
+  if(!window_started){
+      window_started = true;
+      window_ticks = ticks;
+      window_ref = ref;
+      return;
+  }
+  d_ticks = ticks - window_ticks;
+  if(d_ticks < ULFRCO_CAL_WINDOW_TICKS){
+      return;
+  }
+  d_ref = ref - window_ref;
+  window_ticks = ticks;
+  window_ref = ref;
+
+  if(d_ref == 0){
+      cal_telemetry.rejected++;
+      return;
+  }
+  clock_mhz = (uint32_t)(((uint64_t)d_ticks * ULFRCO_CAL_REF_HZ * 1000 + d_ref / 2) / d_ref);
+  current_mhz = letimer_clock_get(LETIMER0);
+  step_ppm = (int32_t)(((int64_t)clock_mhz - current_mhz) * 1000000 / current_mhz);
+  step_abs = step_ppm < 0 ? -step_ppm : step_ppm;
+
+  if(cal_telemetry.calibrations == 0){
+      if(clock_mhz < ULFRCO_CAL_MIN_MHZ || clock_mhz > ULFRCO_CAL_MAX_MHZ){
+          cal_telemetry.rejected++;
+          return;
+      }
+      cal_telemetry.initial_ppm = step_abs;
+  }else{
+      if(step_abs > ULFRCO_CAL_MAX_STEP_PPM){
+          cal_telemetry.rejected++; //reference stopped or was disturbed during the window
+          return;
+      }
+      if(step_abs > cal_telemetry.max_step_ppm){
+          cal_telemetry.max_step_ppm = step_abs;
+      }
+  }
+
+  letimer_clock_set(LETIMER0, clock_mhz);
+  cal_telemetry.clock_mhz = clock_mhz;
+  cal_telemetry.last_step_ppm = step_ppm;
+  cal_telemetry.interval_ms = (uint32_t)((uint64_t)d_ref * 1000 / ULFRCO_CAL_REF_HZ);
+  cal_telemetry.calibrations++;
+}
+
+/***************************************************************************//**
+ * @brief
+ * Copies out the calibration telemetry
+ *
+ * @param[out] stats
+ * Current frequency, number of calibrations and the residual error
+ *
+ ******************************************************************************/
+void ulfrco_cal_stats(ULFRCO_CAL_STATS *stats){
+  *stats = cal_telemetry;
+}
@@ -27,6 +27,9 @@ int main(void)
   /* Chip errata */
   CHIP_Init();
 
+  /* Power down the RAM blocks above the memory used by the firmware */
+  ram_open();
+
   /* Init DCDC regulator and HFXO with kit specific parameters */
   /* Init DCDC regulator and HFXO with kit specific parameters */
   /* Initialize DCDC. Always start in low-noise mode. */
@@ -55,6 +58,11 @@ int main(void)
           enter_sleep();
           CORE_EXIT_CRITICAL();
       }
+      /* Handles cyclic executive minor frame, checked first to keep frame release jitter low */
+      if(CYCLIC_FRAME_CB & get_scheduled_events()){
+          remove_scheduled_event(CYCLIC_FRAME_CB);
+          scheduled_cyclic_frame_cb();
+      }
       /* Handles UF scheduled event */
       if(LETIMER0_UF_CB & get_scheduled_events()){
           remove_scheduled_event(LETIMER0_UF_CB); //removes UF event (because it is currently being handled)
@@ -70,10 +78,14 @@ int main(void)
           remove_scheduled_event(LETIMER0_COMP1_CB); //removes COMP1 event (because it is currently being handled)
           scheduled_letimer0_comp1_cb(); //Handles COMP1 event
       }
-      /* Handles si1133 read scheduled event */
-      if(SI1133_LIGHT_CB & get_scheduled_events()){
-          remove_scheduled_event(SI1133_LIGHT_CB); //removes si1133 read event (because it is currently being handled)
-          scheduled_si1133_read_cb(); //Handles read event
+      /* Handles sensor collect scheduled event */
+      if(SENSOR_COLLECT_CB & get_scheduled_events()){
+          remove_scheduled_event(SENSOR_COLLECT_CB); //removes sensor collect event (because it is currently being handled)
+          scheduled_sensor_collect_cb(); //Handles read event
+      }
+      if(SENSOR_READ_CB & get_scheduled_events()){
+          remove_scheduled_event(SENSOR_READ_CB);
+          scheduled_sensor_read_cb();
       }
       /* Handles UART callback scheduled event */
       if(BOOT_UP_CB & get_scheduled_events()){
@@ -84,5 +96,25 @@ int main(void)
           remove_scheduled_event(BLE_TX_DONE_CB); //removes BLE tx event
           scheduled_ble_tx_done_cb();
       }
+      if(BLE_RX_CB & get_scheduled_events()){
+          remove_scheduled_event(BLE_RX_CB);
+          scheduled_ble_rx_cb();
+      }
+      if(REPLAY_FILL_CB & get_scheduled_events()){
+          remove_scheduled_event(REPLAY_FILL_CB);
+          scheduled_replay_fill_cb();
+      }
+      if(REPLAY_DRAIN_CB & get_scheduled_events()){
+          remove_scheduled_event(REPLAY_DRAIN_CB);
+          scheduled_replay_drain_cb();
+      }
+      if(REPLAY_DONE_CB & get_scheduled_events()){
+          remove_scheduled_event(REPLAY_DONE_CB);
+          scheduled_replay_done_cb();
+      }
+      if(LOG_TX_DONE_CB & get_scheduled_events()){
+          remove_scheduled_event(LOG_TX_DONE_CB);
+          scheduled_log_tx_done_cb();
+      }
   }
 }
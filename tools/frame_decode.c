@@ -0,0 +1,828 @@
+/*
+ * frame_decode.c
+ *
+ * Host library for the binary link frames, see frame_decode.h
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRAME_DEC_X86
+#endif
+#include "frame_decode.h"
+
+#define FRAME_DEC_TYPES         4
+#define FRAME_DEC_PCLMUL_MIN    64      // below this the folding setup costs more than it saves
+
+static uint32_t crc_table[8][256];
+static bool     have_pclmul;
+
+/***************************************************************************//**
+ * Builds the slice-by-8 tables and picks the CRC and scan code for this CPU
+ ******************************************************************************/
+__attribute__((constructor)) static void frame_dec_init(void){
+  for(uint32_t i = 0; i < 256; i++){
+      uint32_t crc = i;
+      for(int k = 0; k < 8; k++){
+          crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+      }
+      crc_table[0][i] = crc;
+  }
+  for(uint32_t i = 0; i < 256; i++){
+      for(int t = 1; t < 8; t++){
+          crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+      }
+  }
+#ifdef FRAME_DEC_X86
+  __builtin_cpu_init();
+  have_pclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+//***********************************************************************************
+// CRC-32, IEEE 802.3 reflected, same results as zlib crc32() and frame_crc32() on the device
+//***********************************************************************************
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *data, size_t length){
+  while(length && ((uintptr_t)data & 7)){
+      crc = (crc >> 8) ^ crc_table[0][(crc ^ *data++) & 0xFF];
+      length--;
+  }
+  while(length >= 8){
+      uint32_t lo, hi;
+      memcpy(&lo, data, 4);
+      memcpy(&hi, data + 4, 4);
+      lo ^= crc;
+      crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF] ^ crc_table[5][(lo >> 16) & 0xFF] ^
+            crc_table[4][lo >> 24] ^ crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF] ^
+            crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+      data += 8;
+      length -= 8;
+  }
+  while(length--){
+      crc = (crc >> 8) ^ crc_table[0][(crc ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+uint32_t frame_dec_crc32_portable(uint32_t crc, const uint8_t *data, size_t length){
+  return ~crc32_slice8(~crc, data, length);
+}
+
+#ifdef FRAME_DEC_X86
+/*
+ * Carry-less multiply folding (Gopal et al., "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"), four
+ * 128 bit lanes folded 64 bytes at a time, then down to 128 bits and a Barrett reduction to 32. length must be a
+ * multiple of 16 and at least 64. crc is the running register, not inverted.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_pclmul(uint32_t crc, const uint8_t *buf, size_t length){
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(buf + 0x00)), _mm_cvtsi32_si128((int)crc));
+  x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+  buf += 64;
+  length -= 64;
+
+  x0 = k1k2;
+  while(length >= 64){
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+      x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+      x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+      x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+      x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+      x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+      x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+      x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+      buf += 64;
+      length -= 64;
+  }
+
+  // four lanes into one
+  x0 = k3k4;
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x4), x5);
+
+  while(length >= 16){
+      x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+      x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+      x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+      buf += 16;
+      length -= 16;
+  }
+
+  // 128 to 64 bits
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x0 = k5k0;
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x00), x2);
+
+  // Barrett reduction to 32 bits
+  x0 = poly;
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+#endif
+
+/***************************************************************************//**
+ * Updates a CRC-32 the way zlib crc32() does, 0 to start
+ ******************************************************************************/
+uint32_t frame_dec_crc32(uint32_t crc, const uint8_t *data, size_t length){
+  crc = ~crc;
+#ifdef FRAME_DEC_X86
+  if(have_pclmul && length >= FRAME_DEC_PCLMUL_MIN){
+      size_t folded = length & ~(size_t)15;
+      crc = crc32_pclmul(crc, data, folded);
+      data += folded;
+      length -= folded;
+  }
+#endif
+  return ~crc32_slice8(crc, data, length);
+}
+
+//***********************************************************************************
+// Sync scan
+//***********************************************************************************
+/***************************************************************************//**
+ * Returns the first FRAME_SYNC0 FRAME_SYNC1 pair that lies entirely in [data, end), or end
+ ******************************************************************************/
+const uint8_t *frame_dec_find_sync_portable(const uint8_t *data, const uint8_t *end){
+  while(end - data >= 2){
+      const uint8_t *p = memchr(data, FRAME_SYNC0, (size_t)(end - data - 1));
+      if(!p){
+          break;
+      }
+      if(p[1] == FRAME_SYNC1){
+          return p;
+      }
+      data = p + 1;
+  }
+  return end;
+}
+
+const uint8_t *frame_dec_find_sync(const uint8_t *data, const uint8_t *end){
+#ifdef FRAME_DEC_X86
+  // SSE2 is part of x86-64: compare 16 positions for the first byte and the next 16 for the second at once
+  const __m128i s0 = _mm_set1_epi8((char)FRAME_SYNC0);
+  const __m128i s1 = _mm_set1_epi8((char)FRAME_SYNC1);
+  while(end - data >= 17){
+      __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)data), s0);
+      __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + 1)), s1);
+      uint32_t hits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b));
+      if(hits){
+          return data + __builtin_ctz(hits);
+      }
+      data += 16;
+  }
+#endif
+  return frame_dec_find_sync_portable(data, end);
+}
+
+//***********************************************************************************
+// Deframing
+//***********************************************************************************
+static uint32_t read_le32(const uint8_t *p){
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/***************************************************************************//**
+ * Finds and checks the frames that start in data[0, limit)
+ *
+ * A frame that starts before limit may end anywhere up to length. A sync whose length or CRC is wrong is skipped one
+ * byte at a time, so the scan picks up again at the next real frame after any corruption. When final is false a frame
+ * cut off by the end of the data is left for the next call, the return value is where that call has to start.
+ * base is the stream offset of data[0], used for the frame offsets.
+ ******************************************************************************/
+size_t frame_dec_scan(const uint8_t *data, size_t length, size_t limit, bool final, uint64_t base,
+                      frame_dec_cb cb, void *ctx, FRAME_DEC_STATS *stats){
+  size_t search_end = limit < length ? limit + 1 : length;
+  size_t pos = 0;
+
+  while(pos < limit){
+      const uint8_t *p = frame_dec_find_sync(data + pos, data + search_end);
+      size_t at = (size_t)(p - data);
+      if(at == search_end){
+          if(!final && limit == length && data[length - 1] == FRAME_SYNC0){
+              stats->skipped_bytes += length - 1 - pos;    // may be the first half of a sync
+              return length - 1;
+          }
+          stats->skipped_bytes += limit - pos;
+          return limit;
+      }
+      stats->skipped_bytes += at - pos;
+      pos = at;
+
+      if(length - pos < FRAME_HEADER_SIZE){
+          if(!final){
+              return pos;
+          }
+          stats->skipped_bytes++;
+          pos++;
+          continue;
+      }
+      uint32_t payload = data[pos + 4] | (uint32_t)data[pos + 5] << 8;
+      if(payload > FRAME_PAYLOAD_MAX){
+          stats->bad_lengths++;
+          stats->skipped_bytes++;
+          pos++;
+          continue;
+      }
+      size_t end = pos + FRAME_SIZE(payload);
+      if(end > length){
+          if(!final){
+              return pos;
+          }
+          stats->skipped_bytes++;
+          pos++;
+          continue;
+      }
+      if(frame_dec_crc32(0, data + pos + 2, payload + 4) != read_le32(data + pos + FRAME_HEADER_SIZE + payload)){
+          stats->crc_errors++;
+          stats->skipped_bytes++;
+          pos++;
+          continue;
+      }
+      stats->frames++;
+      stats->payload_bytes += payload;
+      stats->frame_bytes += FRAME_SIZE(payload);
+      if(cb){
+          FRAME_DEC_FRAME frame = {data[pos + 2], data[pos + 3], (uint16_t)payload, data + pos + FRAME_HEADER_SIZE,
+                                   base + pos};
+          cb(&frame, ctx);
+      }
+      pos = end;
+  }
+  return pos;
+}
+
+void frame_dec_parser_init(FRAME_DEC_PARSER *parser){
+  memset(parser, 0, sizeof(*parser));
+}
+
+/***************************************************************************//**
+ * Adds bytes to the stream, cb is called for every frame completed by them
+ *
+ * The payload pointer handed to cb is only valid during the call.
+ ******************************************************************************/
+void frame_dec_parser_feed(FRAME_DEC_PARSER *parser, const uint8_t *data, size_t length, frame_dec_cb cb, void *ctx){
+  size_t used;
+
+  if(parser->len + length > parser->cap){
+      parser->cap = (parser->len + length) * 2 + FRAME_SIZE(FRAME_PAYLOAD_MAX);
+      parser->buf = realloc(parser->buf, parser->cap);
+      if(!parser->buf){
+          perror("frame_dec_parser_feed");
+          exit(1);
+      }
+  }
+  memcpy(parser->buf + parser->len, data, length);
+  parser->len += length;
+  if(!parser->len){
+      return;
+  }
+  used = frame_dec_scan(parser->buf, parser->len, parser->len, false, parser->base, cb, ctx, &parser->stats);
+  memmove(parser->buf, parser->buf + used, parser->len - used);
+  parser->len -= used;
+  parser->base += used;
+}
+
+/***************************************************************************//**
+ * Ends the stream, the bytes still held are scanned as if nothing follows them
+ ******************************************************************************/
+void frame_dec_parser_finish(FRAME_DEC_PARSER *parser, frame_dec_cb cb, void *ctx){
+  if(parser->len){
+      frame_dec_scan(parser->buf, parser->len, parser->len, true, parser->base, cb, ctx, &parser->stats);
+      parser->base += parser->len;
+      parser->len = 0;
+  }
+}
+
+void frame_dec_parser_free(FRAME_DEC_PARSER *parser){
+  free(parser->buf);
+  memset(parser, 0, sizeof(*parser));
+}
+
+//***********************************************************************************
+// LOG() format strings
+//***********************************************************************************
+static int format_nargs(const char *fmt){
+  int count = 0;
+
+  for(; *fmt; fmt++){
+      if(*fmt != '%'){
+          continue;
+      }
+      fmt++;
+      fmt += strspn(fmt, "-+ 0#");
+      fmt += strspn(fmt, "0123456789");
+      if(*fmt == '.'){
+          fmt++;
+          fmt += strspn(fmt, "0123456789");
+      }
+      if(!*fmt){
+          break;
+      }
+      if(strchr("diuxXc", *fmt)){
+          count++;
+      }
+  }
+  return count;
+}
+
+/***************************************************************************//**
+ * Reads the .log_fmt section of a little endian ELF32, the id of a LOG() site is the offset of its string
+ ******************************************************************************/
+bool frame_dec_formats_load(FRAME_DEC_FORMATS *formats, const char *elf_path){
+  FILE *f = fopen(elf_path, "rb");
+  uint8_t *elf = NULL;
+  long size;
+  bool found = false;
+
+  memset(formats, 0, sizeof(*formats));
+  if(!f){
+      return false;
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  elf = malloc((size_t)size);
+  if(elf && fread(elf, 1, (size_t)size, f) == (size_t)size && size > 0x34 && !memcmp(elf, "\177ELF\1\1", 6)){
+      uint32_t shoff = read_le32(elf + 0x20);
+      uint32_t shentsize = elf[0x2E] | elf[0x2F] << 8, shnum = elf[0x30] | elf[0x31] << 8;
+      uint32_t shstrndx = elf[0x32] | elf[0x33] << 8;
+      if(shoff + (uint64_t)shnum * shentsize <= (uint64_t)size && shstrndx < shnum){
+          uint32_t names = read_le32(elf + shoff + shstrndx * shentsize + 0x10);
+          for(uint32_t i = 0; i < shnum && !found; i++){
+              const uint8_t *sh = elf + shoff + i * shentsize;
+              uint32_t name = read_le32(sh), offset = read_le32(sh + 0x10), length = read_le32(sh + 0x14);
+              if(names + name < (uint64_t)size && !strcmp((const char *)elf + names + name, ".log_fmt") &&
+                 offset + (uint64_t)length <= (uint64_t)size){
+                  formats->data = malloc(length + 1);
+                  memcpy(formats->data, elf + offset, length);
+                  formats->data[length] = 0;
+                  formats->size = length;
+                  found = true;
+              }
+          }
+      }
+  }
+  free(elf);
+  fclose(f);
+  if(!found){
+      return false;
+  }
+  formats->nargs = malloc(formats->size + 1);
+  memset(formats->nargs, -1, formats->size + 1);
+  for(size_t id = 0; id < formats->size; id++){
+      if(id == 0 || formats->data[id - 1] == 0){
+          formats->nargs[id] = (int8_t)format_nargs((const char *)formats->data + id);
+      }
+  }
+  return true;
+}
+
+void frame_dec_formats_free(FRAME_DEC_FORMATS *formats){
+  free(formats->data);
+  free(formats->nargs);
+  memset(formats, 0, sizeof(*formats));
+}
+
+//***********************************************************************************
+// Output
+//***********************************************************************************
+static void text_reserve(FRAME_DEC_TEXT *text, size_t length){
+  if(text->len + length + 1 > text->cap){
+      text->cap = (text->len + length + 1) * 2 + 4096;
+      text->data = realloc(text->data, text->cap);
+      if(!text->data){
+          perror("frame_dec_text");
+          exit(1);
+      }
+  }
+}
+
+void frame_dec_text_append(FRAME_DEC_TEXT *text, const void *data, size_t length){
+  text_reserve(text, length);
+  memcpy(text->data + text->len, data, length);
+  text->len += length;
+}
+
+void frame_dec_text_printf(FRAME_DEC_TEXT *text, const char *fmt, ...){
+  va_list args;
+  int length;
+
+  text_reserve(text, 128);
+  va_start(args, fmt);
+  length = vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+  va_end(args);
+  if((size_t)length >= text->cap - text->len){
+      text_reserve(text, (size_t)length);
+      va_start(args, fmt);
+      vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+      va_end(args);
+  }
+  text->len += (size_t)length;
+}
+
+void frame_dec_text_free(FRAME_DEC_TEXT *text){
+  free(text->data);
+  memset(text, 0, sizeof(*text));
+}
+
+// Appends a decimal number, the CSV columns are written without printf so the output keeps up with the deframing
+static void text_u32(FRAME_DEC_TEXT *text, uint32_t value, bool negative){
+  char digits[11];
+  int n = 0;
+
+  do{
+      digits[n++] = (char)('0' + value % 10);
+      value /= 10;
+  }while(value);
+  text_reserve(text, 12);
+  if(negative){
+      text->data[text->len++] = '-';
+  }
+  while(n){
+      text->data[text->len++] = digits[--n];
+  }
+}
+
+static void text_i32(FRAME_DEC_TEXT *text, int32_t value){
+  text_u32(text, value < 0 ? 0u - (uint32_t)value : (uint32_t)value, value < 0);
+}
+
+static void text_char(FRAME_DEC_TEXT *text, char c){
+  text_reserve(text, 1);
+  text->data[text->len++] = c;
+}
+
+// Appends str as a quoted CSV field, the trailing newline of a log line is dropped
+static void text_csv_field(FRAME_DEC_TEXT *text, const char *str, size_t length){
+  while(length && (str[length - 1] == '\n' || str[length - 1] == '\r')){
+      length--;
+  }
+  text_reserve(text, length * 2 + 2);
+  text->data[text->len++] = '"';
+  for(size_t i = 0; i < length; i++){
+      if(str[i] == '"'){
+          text->data[text->len++] = '"';
+      }
+      text->data[text->len++] = str[i];
+  }
+  text->data[text->len++] = '"';
+}
+
+// Expands a LOG() format the way the device printf would have, with the 32 bit argument words
+static void format_record(FRAME_DEC_TEXT *line, const char *fmt, const uint32_t *args){
+  char spec[32], value[64];
+
+  while(*fmt){
+      const char *start = fmt;
+      if(*fmt != '%'){
+          const char *next = strchr(fmt, '%');
+          size_t length = next ? (size_t)(next - fmt) : strlen(fmt);
+          frame_dec_text_append(line, fmt, length);
+          fmt += length;
+          continue;
+      }
+      fmt++;
+      fmt += strspn(fmt, "-+ 0#");
+      fmt += strspn(fmt, "0123456789");
+      if(*fmt == '.'){
+          fmt++;
+          fmt += strspn(fmt, "0123456789");
+      }
+      if(!*fmt){
+          frame_dec_text_append(line, start, strlen(start));
+          break;
+      }
+      size_t length = (size_t)(fmt - start);
+      if(length > sizeof(spec) - 3){
+          length = sizeof(spec) - 3;
+      }
+      memcpy(spec, start, length);
+      char kind = *fmt++;
+      int n;
+      if(length == 1 && (kind == 'd' || kind == 'i' || kind == 'u')){
+          if(kind == 'u'){
+              text_u32(line, *args++, false);
+          }else{
+              text_i32(line, (int32_t)*args++);
+          }
+          continue;
+      }
+      switch(kind){
+        case 'd':
+        case 'i':
+          spec[length] = 'd';
+          spec[length + 1] = 0;
+          n = snprintf(value, sizeof(value), spec, (int32_t)*args++);
+          break;
+        case 'u':
+        case 'x':
+        case 'X':
+          spec[length] = kind;
+          spec[length + 1] = 0;
+          n = snprintf(value, sizeof(value), spec, *args++);
+          break;
+        case 'c':
+          spec[length] = 'c';
+          spec[length + 1] = 0;
+          n = snprintf(value, sizeof(value), spec, (int)(*args++ & 0xFF));
+          break;
+        case '%':
+          value[0] = '%';
+          n = 1;
+          break;
+        default:
+          memcpy(value, start, (size_t)(fmt - start));
+          n = (int)(fmt - start);
+          break;
+      }
+      frame_dec_text_append(line, value, n < (int)sizeof(value) ? (size_t)n : sizeof(value) - 1);
+  }
+}
+
+/***************************************************************************//**
+ * Appends a CSV row per LOG() record of a log frame, false if the frame could not be decoded to the end
+ ******************************************************************************/
+bool frame_dec_log_csv(const FRAME_DEC_FRAME *frame, const FRAME_DEC_FORMATS *formats, const char *source,
+                       FRAME_DEC_TEXT *out){
+  const uint8_t *p = frame->payload, *end = frame->payload + frame->length;
+  FRAME_DEC_TEXT line = {0};
+  uint32_t args[FRAME_DEC_LOG_ARGS_MAX];
+  uint32_t time_ms;
+  bool complete = true;
+
+  if(frame->length < 4){
+      return false;
+  }
+  time_ms = read_le32(p);
+  p += 4;
+  while(end - p >= 2){
+      uint32_t id = p[0] | (uint32_t)p[1] << 8;
+      int nargs;
+      p += 2;
+      line.len = 0;
+      if(id == FRAME_DEC_LOG_ID_DROPPED){
+          if(end - p < 4){
+              complete = false;
+              break;
+          }
+          frame_dec_text_printf(&line, "<%u records dropped>", read_le32(p));
+          p += 4;
+      }else{
+          nargs = formats && formats->nargs && id < formats->size ? formats->nargs[id] : -1;
+          if(nargs < 0 || nargs > FRAME_DEC_LOG_ARGS_MAX || end - p < 4 * nargs){
+              complete = false;
+              break;
+          }
+          for(int i = 0; i < nargs; i++){
+              args[i] = read_le32(p);
+              p += 4;
+          }
+          format_record(&line, (const char *)formats->data + id, args);
+      }
+      text_csv_field(out, source, strlen(source));
+      text_char(out, ',');
+      text_u32(out, frame->seq, false);
+      text_char(out, ',');
+      text_u32(out, time_ms, false);
+      text_char(out, ',');
+      text_csv_field(out, line.data, line.len);
+      frame_dec_text_append(out, "\n", 1);
+  }
+  frame_dec_text_free(&line);
+  return complete;
+}
+
+/***************************************************************************//**
+ * Appends a CSV row per point of a downsampled history frame
+ ******************************************************************************/
+bool frame_dec_history_csv(const FRAME_DEC_FRAME *frame, const char *source, FRAME_DEC_TEXT *out){
+  for(uint32_t i = 0; i + FRAME_DEC_POINT_SIZE <= frame->length; i += FRAME_DEC_POINT_SIZE){
+      text_csv_field(out, source, strlen(source));
+      text_char(out, ',');
+      text_u32(out, frame->seq, false);
+      text_char(out, ',');
+      text_u32(out, read_le32(frame->payload + i), false);
+      text_char(out, ',');
+      text_i32(out, (int32_t)read_le32(frame->payload + i + 4));
+      text_char(out, '\n');
+  }
+  return frame->length % FRAME_DEC_POINT_SIZE == 0;
+}
+
+//***********************************************************************************
+// Parallel decode
+//***********************************************************************************
+typedef struct {
+  const FRAME_DEC_INPUT *input;
+  size_t        start;
+  size_t        limit;
+  size_t        end;              // where the scan stopped, past limit if the last frame straddles it
+  FRAME_DEC_CHUNK out;
+  bool          done;
+} DECODE_JOB;
+
+typedef struct {
+  DECODE_JOB    *jobs;
+  size_t        count;
+  size_t        next;
+  const FRAME_DEC_FORMATS *formats;
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+} DECODE_QUEUE;
+
+typedef struct {
+  DECODE_JOB    *job;
+  const FRAME_DEC_FORMATS *formats;
+} DECODE_CTX;
+
+static void decode_frame(const FRAME_DEC_FRAME *frame, void *ctx){
+  DECODE_CTX *decode = ctx;
+  FRAME_DEC_CHUNK *out = &decode->job->out;
+  const char *source = decode->job->input->name;
+
+  if(frame->type < FRAME_DEC_TYPES){
+      if(out->first_seq[frame->type] < 0){
+          out->first_seq[frame->type] = frame->seq;
+      }else{
+          out->lost += (uint8_t)(frame->seq - out->last_seq[frame->type] - 1);
+      }
+      out->last_seq[frame->type] = frame->seq;
+  }
+  switch(frame->type){
+    case frame_type_log:
+      if(!frame_dec_log_csv(frame, decode->formats, source, &out->log_csv)){
+          out->log_undecoded++;
+      }
+      break;
+    case frame_type_history:
+      frame_dec_history_csv(frame, source, &out->history_csv);
+      break;
+    case frame_type_replay:
+      frame_dec_text_append(&out->replay, frame->payload, frame->length);
+      break;
+    default:
+      break;
+  }
+}
+
+static void decode_job(DECODE_JOB *job, const FRAME_DEC_FORMATS *formats){
+  DECODE_CTX ctx = {job, formats};
+  const uint8_t *data = job->input->data + job->start;
+
+  for(int t = 0; t < FRAME_DEC_TYPES; t++){
+      job->out.first_seq[t] = -1;
+      job->out.last_seq[t] = -1;
+  }
+  job->out.input = job->input;
+  job->end = job->start + frame_dec_scan(data, job->input->size - job->start, job->limit - job->start, true,
+                                         job->start, decode_frame, &ctx, &job->out.stats);
+}
+
+static void *decode_worker(void *arg){
+  DECODE_QUEUE *queue = arg;
+
+  for(;;){
+      pthread_mutex_lock(&queue->lock);
+      size_t i = queue->next++;
+      pthread_mutex_unlock(&queue->lock);
+      if(i >= queue->count){
+          return NULL;
+      }
+      decode_job(&queue->jobs[i], queue->formats);
+      pthread_mutex_lock(&queue->lock);
+      queue->jobs[i].done = true;
+      pthread_cond_broadcast(&queue->done);
+      pthread_mutex_unlock(&queue->lock);
+  }
+}
+
+/***************************************************************************//**
+ * Decodes every frame of the inputs, split in chunks decoded in parallel
+ *
+ * Each input is cut into chunk_size pieces and each piece is scanned for the frames that start in it, by as many
+ * threads as asked for. A piece starts scanning at an arbitrary byte, which the resync handles like any corruption.
+ * The sink gets the chunks in input order from the calling thread, as soon as each is done, so output is
+ * deterministic whatever the thread count. Counts that depend on where a chunk starts are fixed up here: the
+ * bytes a straddling frame of the previous chunk covers are not skipped bytes, and the sequence numbers are checked
+ * across chunk boundaries.
+ ******************************************************************************/
+void frame_dec_decode(const FRAME_DEC_INPUT *inputs, size_t count, const FRAME_DEC_FORMATS *formats,
+                      size_t chunk_size, unsigned threads, frame_dec_sink sink, void *ctx, FRAME_DEC_SUMMARY *summary){
+  DECODE_QUEUE queue = {0};
+  pthread_t *workers;
+  size_t jobs = 0, j = 0;
+  int last_seq[FRAME_DEC_TYPES];
+
+  if(chunk_size < 2 * FRAME_SIZE(FRAME_PAYLOAD_MAX)){
+      chunk_size = 2 * FRAME_SIZE(FRAME_PAYLOAD_MAX);
+  }
+  for(size_t i = 0; i < count; i++){
+      jobs += inputs[i].size ? (inputs[i].size + chunk_size - 1) / chunk_size : 0;
+  }
+  queue.jobs = calloc(jobs ? jobs : 1, sizeof(DECODE_JOB));
+  for(size_t i = 0; i < count; i++){
+      for(size_t start = 0; start < inputs[i].size; start += chunk_size){
+          queue.jobs[j].input = &inputs[i];
+          queue.jobs[j].start = start;
+          queue.jobs[j].limit = start + chunk_size < inputs[i].size ? start + chunk_size : inputs[i].size;
+          j++;
+      }
+  }
+  queue.count = jobs;
+  queue.formats = formats;
+  pthread_mutex_init(&queue.lock, NULL);
+  pthread_cond_init(&queue.done, NULL);
+  if(threads < 1){
+      threads = 1;
+  }
+  workers = calloc(threads, sizeof(pthread_t));
+  for(unsigned t = 0; t < threads; t++){
+      pthread_create(&workers[t], NULL, decode_worker, &queue);
+  }
+
+  memset(summary, 0, sizeof(*summary));
+  size_t prev_end = 0;
+  for(size_t i = 0; i < jobs; i++){
+      DECODE_JOB *job = &queue.jobs[i];
+      pthread_mutex_lock(&queue.lock);
+      while(!job->done){
+          pthread_cond_wait(&queue.done, &queue.lock);
+      }
+      pthread_mutex_unlock(&queue.lock);
+
+      if(job->start == 0){
+          prev_end = 0;
+          for(int t = 0; t < FRAME_DEC_TYPES; t++){
+              last_seq[t] = -1;
+          }
+      }else if(prev_end > job->start){
+          // the scan of this chunk started inside the last frame of the previous one, drop what it found in there
+          FRAME_DEC_STATS inside = {0};
+          frame_dec_scan(job->input->data + job->start, job->input->size - job->start, prev_end - job->start, true,
+                         job->start, NULL, NULL, &inside);
+          job->out.stats.crc_errors -= inside.crc_errors;
+          job->out.stats.bad_lengths -= inside.bad_lengths;
+          job->out.stats.skipped_bytes -= prev_end - job->start < job->out.stats.skipped_bytes ?
+                                          prev_end - job->start : job->out.stats.skipped_bytes;
+      }
+      for(int t = 0; t < FRAME_DEC_TYPES; t++){
+          if(job->out.first_seq[t] >= 0){
+              if(last_seq[t] >= 0){
+                  job->out.lost += (uint8_t)(job->out.first_seq[t] - last_seq[t] - 1);
+              }
+              last_seq[t] = job->out.last_seq[t];
+          }
+      }
+      prev_end = job->end;
+
+      sink(&job->out, ctx);
+      summary->stats.frames += job->out.stats.frames;
+      summary->stats.payload_bytes += job->out.stats.payload_bytes;
+      summary->stats.frame_bytes += job->out.stats.frame_bytes;
+      summary->stats.crc_errors += job->out.stats.crc_errors;
+      summary->stats.bad_lengths += job->out.stats.bad_lengths;
+      summary->stats.skipped_bytes += job->out.stats.skipped_bytes;
+      summary->log_undecoded += job->out.log_undecoded;
+      summary->lost += job->out.lost;
+      summary->bytes += job->limit - job->start;
+      frame_dec_text_free(&job->out.log_csv);
+      frame_dec_text_free(&job->out.history_csv);
+      frame_dec_text_free(&job->out.replay);
+  }
+
+  for(unsigned t = 0; t < threads; t++){
+      pthread_join(workers[t], NULL);
+  }
+  pthread_mutex_destroy(&queue.lock);
+  pthread_cond_destroy(&queue.done);
+  free(workers);
+  free(queue.jobs);
+}
@@ -0,0 +1,121 @@
+/*
+ * frame_decode.h
+ *
+ * Host library that takes the binary link frames of src/Header Files/frame.h back apart: finds the frames in a
+ * capture or flash dump, checks their CRC, resynchronises after corrupted or missing bytes, and turns the log,
+ * history and replay payloads into CSV rows or raw bytes. Used by frame_decode_main.c (CLI) and
+ * frame_decode_bench.c.
+ *
+ *   gcc -O2 -pthread -I"src/Header Files" -Itools/host tools/frame_decode.c tools/frame_decode_main.c -o frame_decode
+ *
+ * The sync scan uses SSE2 and the CRC uses PCLMULQDQ folding when the host has them (x86-64), both fall back to
+ * portable code (memchr, slice-by-8 tables) elsewhere and give the same results.
+ */
+#ifndef FRAME_DECODE_H
+#define FRAME_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame.h"
+
+#define FRAME_DEC_LOG_ARGS_MAX  4           // LOG() sites take at most 4 arguments (log.h)
+#define FRAME_DEC_LOG_ID_DROPPED 0xFFFF     // LOG_ID_DROPPED
+#define FRAME_DEC_POINT_SIZE    8           // REPLAY_POINT_SIZE, {uint32 ms, int32 value}
+
+typedef struct {
+  uint8_t       type;             // FRAME_TYPE
+  uint8_t       seq;
+  uint16_t      length;
+  const uint8_t *payload;
+  uint64_t      offset;           // of the sync bytes in the stream
+} FRAME_DEC_FRAME;
+
+typedef struct {
+  uint64_t      frames;
+  uint64_t      payload_bytes;
+  uint64_t      frame_bytes;      // payload plus framing of the accepted frames
+  uint64_t      crc_errors;       // sync and length looked right but the CRC did not match
+  uint64_t      bad_lengths;      // sync followed by a length above FRAME_PAYLOAD_MAX
+  uint64_t      skipped_bytes;    // bytes outside of accepted frames
+} FRAME_DEC_STATS;
+
+typedef void (*frame_dec_cb)(const FRAME_DEC_FRAME *frame, void *ctx);
+
+// Streaming parser, bytes can be fed in pieces of any size (ex. as read from a serial port)
+typedef struct {
+  uint8_t       *buf;
+  size_t        len;
+  size_t        cap;
+  uint64_t      base;             // stream offset of buf[0]
+  FRAME_DEC_STATS stats;
+} FRAME_DEC_PARSER;
+
+// Format strings of the LOG() sites, read from the .log_fmt section of the firmware ELF
+typedef struct {
+  uint8_t       *data;
+  size_t        size;
+  int8_t        *nargs;           // by id, conversions in the string starting at that id, -1 if none starts there
+} FRAME_DEC_FORMATS;
+
+// Growable output buffer
+typedef struct {
+  char          *data;
+  size_t        len;
+  size_t        cap;
+} FRAME_DEC_TEXT;
+
+// A whole capture or dump to decode
+typedef struct {
+  const uint8_t *data;
+  size_t        size;
+  const char    *name;            // source column of the CSV rows
+} FRAME_DEC_INPUT;
+
+// Output of one chunk of an input, handed to the sink in input order
+typedef struct {
+  const FRAME_DEC_INPUT *input;
+  FRAME_DEC_TEXT log_csv;         // source,seq,time_ms,text
+  FRAME_DEC_TEXT history_csv;     // source,seq,time_ms,value
+  FRAME_DEC_TEXT replay;          // replayed flash bytes, in order
+  FRAME_DEC_STATS stats;
+  uint64_t      log_undecoded;    // log frames cut short by an unknown id or without the ELF
+  int           first_seq[4];     // by FRAME_TYPE, -1 if the chunk has no frame of that type
+  int           last_seq[4];
+  uint64_t      lost;             // sequence numbers missing between frames of the chunk
+} FRAME_DEC_CHUNK;
+
+typedef struct {
+  FRAME_DEC_STATS stats;
+  uint64_t      log_undecoded;
+  uint64_t      lost;             // frames missing from the sequence numbers, per type, across chunks
+  uint64_t      bytes;
+} FRAME_DEC_SUMMARY;
+
+typedef void (*frame_dec_sink)(const FRAME_DEC_CHUNK *chunk, void *ctx);
+
+uint32_t frame_dec_crc32(uint32_t crc, const uint8_t *data, size_t length);
+uint32_t frame_dec_crc32_portable(uint32_t crc, const uint8_t *data, size_t length);
+const uint8_t *frame_dec_find_sync(const uint8_t *data, const uint8_t *end);
+const uint8_t *frame_dec_find_sync_portable(const uint8_t *data, const uint8_t *end);
+size_t frame_dec_scan(const uint8_t *data, size_t length, size_t limit, bool final, uint64_t base,
+                      frame_dec_cb cb, void *ctx, FRAME_DEC_STATS *stats);
+
+void frame_dec_parser_init(FRAME_DEC_PARSER *parser);
+void frame_dec_parser_feed(FRAME_DEC_PARSER *parser, const uint8_t *data, size_t length, frame_dec_cb cb, void *ctx);
+void frame_dec_parser_finish(FRAME_DEC_PARSER *parser, frame_dec_cb cb, void *ctx);
+void frame_dec_parser_free(FRAME_DEC_PARSER *parser);
+
+bool frame_dec_formats_load(FRAME_DEC_FORMATS *formats, const char *elf_path);
+void frame_dec_formats_free(FRAME_DEC_FORMATS *formats);
+
+void frame_dec_text_printf(FRAME_DEC_TEXT *text, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void frame_dec_text_append(FRAME_DEC_TEXT *text, const void *data, size_t length);
+void frame_dec_text_free(FRAME_DEC_TEXT *text);
+bool frame_dec_log_csv(const FRAME_DEC_FRAME *frame, const FRAME_DEC_FORMATS *formats, const char *source,
+                       FRAME_DEC_TEXT *out);
+bool frame_dec_history_csv(const FRAME_DEC_FRAME *frame, const char *source, FRAME_DEC_TEXT *out);
+void frame_dec_decode(const FRAME_DEC_INPUT *inputs, size_t count, const FRAME_DEC_FORMATS *formats,
+                      size_t chunk_size, unsigned threads, frame_dec_sink sink, void *ctx, FRAME_DEC_SUMMARY *summary);
+
+#endif
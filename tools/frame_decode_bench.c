@@ -0,0 +1,240 @@
+/*
+ * frame_decode_bench.c
+ *
+ * Host throughput benchmark of the frame decoder in frame_decode.c
+ *
+ *   gcc -O2 -pthread -I"src/Header Files" -Itools/host tools/frame_decode_bench.c tools/frame_decode.c \
+ *       "src/Source Files/frame.c" -o frame_decode_bench
+ *   ./frame_decode_bench [stream_mb] [threads]
+ *
+ * A stream of log, history and replay frames sealed by the device's frame_seal() is built with bit flips, dropped
+ * bytes and line noise between some frames. Each stage of the decode is timed on it in MB/s of stream: the CRC
+ * (the device nibble table, slice-by-8 and PCLMULQDQ folding), the sync scan (memchr and SSE2), deframing alone and
+ * the full decode to CSV on one thread and on the given number of threads. The variants are checked to agree and the
+ * decoder is checked to find every frame that was not corrupted.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame_decode.h"
+
+#define CORRUPT_EVERY   200             // one frame in this many gets a bit flipped
+#define DROP_EVERY      500             // one frame in this many loses a byte
+#define NOISE_EVERY     50              // noise bytes after one frame in this many
+#define REPEATS         5
+
+// Format blob laid out like a .log_fmt section, ids are the offsets of the strings
+static const char log_fmt[] = "boot %u\n\0light %d lux\n\0temp %d.%02d C rh %d%%\n\0state 0x%08X\n";
+static uint16_t log_ids[4];
+static const int log_nargs[4] = {1, 1, 3, 1};
+
+static double now_s(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void put_le32(uint8_t *p, uint32_t v){
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t build_payload(uint8_t *payload, FRAME_TYPE type, uint32_t time_ms){
+  uint32_t length = 0;
+
+  switch(type){
+    case frame_type_log:
+      put_le32(payload, time_ms);
+      length = 4;
+      while(length + 2 + 4 * 3 <= 120){
+          int which = rand() % 4;
+          payload[length++] = (uint8_t)log_ids[which];
+          payload[length++] = (uint8_t)(log_ids[which] >> 8);
+          for(int i = 0; i < log_nargs[which]; i++){
+              put_le32(payload + length, (uint32_t)rand());
+              length += 4;
+          }
+      }
+      break;
+    case frame_type_history:
+      for(; length + 8 <= 240; length += 8){
+          put_le32(payload + length, time_ms + length * 250);
+          put_le32(payload + length + 4, (uint32_t)(rand() % 2000 - 1000));
+      }
+      break;
+    default:
+      length = 240;
+      for(uint32_t i = 0; i < length; i++){
+          payload[i] = (uint8_t)rand();
+      }
+      break;
+  }
+  return length;
+}
+
+// Returns the stream, good is set to the frames that were left intact
+static uint8_t *build_stream(size_t size, size_t *length, uint64_t *good){
+  uint8_t *stream = malloc(size + FRAME_SIZE(FRAME_PAYLOAD_MAX) + 64);
+  uint8_t seq[4] = {0};
+  size_t pos = 0;
+  uint32_t n = 0;
+
+  srand(1);
+  *good = 0;
+  while(pos < size){
+      static const FRAME_TYPE types[] = {frame_type_replay, frame_type_replay, frame_type_log, frame_type_history};
+      FRAME_TYPE type = types[n % 4];
+      uint8_t *frame = stream + pos;
+      uint32_t payload = build_payload(frame + FRAME_HEADER_SIZE, type, n * 1000);
+      uint32_t bytes = frame_seal(frame, type, seq[type]++, payload);
+      n++;
+      if(n % CORRUPT_EVERY == 0){
+          frame[2 + rand() % (bytes - 2)] ^= (uint8_t)(1 << (rand() % 8));
+      }else if(n % DROP_EVERY == 7){
+          uint32_t at = 2 + rand() % (bytes - 2);
+          memmove(frame + at, frame + at + 1, bytes - at - 1);
+          bytes--;
+      }else{
+          (*good)++;
+      }
+      pos += bytes;
+      if(n % NOISE_EVERY == 3){
+          for(int i = rand() % 64; i >= 0; i--){
+              stream[pos++] = (uint8_t)(rand() % 3 ? rand() : FRAME_SYNC0);
+          }
+      }
+  }
+  *length = pos;
+  return stream;
+}
+
+static void count_frame(const FRAME_DEC_FRAME *frame, void *ctx){
+  (void)frame;
+  (*(uint64_t *)ctx)++;
+}
+
+static void null_sink(const FRAME_DEC_CHUNK *chunk, void *ctx){
+  *(uint64_t *)ctx += chunk->log_csv.len + chunk->history_csv.len + chunk->replay.len;
+}
+
+static void report(const char *name, double seconds, size_t bytes){
+  printf("  %-34s %9.1f MB/s\n", name, bytes / 1e6 / seconds);
+}
+
+int main(int argc, char **argv){
+  size_t size = (argc > 1 ? strtoul(argv[1], NULL, 0) : 64) << 20;
+  unsigned threads = argc > 2 ? (unsigned)atoi(argv[2]) : (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+  FRAME_DEC_FORMATS formats = {0};
+  FRAME_DEC_INPUT input;
+  FRAME_DEC_SUMMARY summary;
+  FRAME_DEC_STATS stats;
+  uint64_t good, frames, out_bytes;
+  size_t length;
+  double t, best;
+  uint32_t crc[3];
+  uint64_t syncs[2];
+  uint8_t *stream;
+  bool ok = true;
+
+  formats.data = (uint8_t *)log_fmt;
+  formats.size = sizeof(log_fmt);
+  formats.nargs = malloc(formats.size);
+  memset(formats.nargs, -1, formats.size);
+  for(size_t id = 0, i = 0; i < 4; id += strlen(log_fmt + id) + 1, i++){
+      log_ids[i] = (uint16_t)id;
+      formats.nargs[id] = (int8_t)log_nargs[i];
+  }
+
+  stream = build_stream(size, &length, &good);
+  input = (FRAME_DEC_INPUT){stream, length, "bench"};
+  printf("stream %.1f MB, %llu intact frames\n", length / 1e6, (unsigned long long)good);
+
+  printf("crc\n");
+  t = now_s();
+  crc[0] = frame_crc32(0, stream, (uint32_t)length);
+  report("device nibble table", now_s() - t, length);
+  for(int variant = 1; variant < 3; variant++){
+      best = 1e9;
+      for(int r = 0; r < REPEATS; r++){
+          t = now_s();
+          crc[variant] = variant == 1 ? frame_dec_crc32_portable(0, stream, length) : frame_dec_crc32(0, stream, length);
+          t = now_s() - t;
+          best = t < best ? t : best;
+      }
+      report(variant == 1 ? "slice-by-8" : "dispatched (PCLMULQDQ if present)", best, length);
+  }
+  ok &= crc[0] == crc[1] && crc[1] == crc[2];
+
+  printf("sync scan, every A5 5A in the stream\n");
+  for(int variant = 0; variant < 2; variant++){
+      best = 1e9;
+      for(int r = 0; r < REPEATS; r++){
+          const uint8_t *p = stream, *end = stream + length;
+          syncs[variant] = 0;
+          t = now_s();
+          while((p = variant ? frame_dec_find_sync(p, end) : frame_dec_find_sync_portable(p, end)) < end){
+              syncs[variant]++;
+              p++;
+          }
+          t = now_s() - t;
+          best = t < best ? t : best;
+      }
+      report(variant ? "SSE2" : "memchr", best, length);
+  }
+  ok &= syncs[0] == syncs[1];
+
+  printf("decode\n");
+  best = 1e9;
+  for(int r = 0; r < REPEATS; r++){
+      memset(&stats, 0, sizeof(stats));
+      frames = 0;
+      t = now_s();
+      frame_dec_scan(stream, length, length, true, 0, count_frame, &frames, &stats);
+      t = now_s() - t;
+      best = t < best ? t : best;
+  }
+  report("deframe and CRC check", best, length);
+  ok &= frames == good && stats.frame_bytes + stats.skipped_bytes == length;
+
+  FRAME_DEC_PARSER parser;
+  frame_dec_parser_init(&parser);
+  frames = 0;
+  t = now_s();
+  for(size_t pos = 0; pos < length; pos += 4093){
+      frame_dec_parser_feed(&parser, stream + pos, length - pos < 4093 ? length - pos : 4093, count_frame, &frames);
+  }
+  frame_dec_parser_finish(&parser, count_frame, &frames);
+  report("streaming parser, 4093 byte reads", now_s() - t, length);
+  ok &= frames == good && parser.stats.crc_errors == stats.crc_errors &&
+        parser.stats.skipped_bytes == stats.skipped_bytes;
+  frame_dec_parser_free(&parser);
+
+  uint64_t single_bytes = 0;
+  for(unsigned n = 1; n <= threads; n = n < threads ? threads : n + 1){
+      char name[64];
+      out_bytes = 0;
+      t = now_s();
+      frame_dec_decode(&input, 1, &formats, 4 << 20, n, null_sink, &out_bytes, &summary);
+      t = now_s() - t;
+      snprintf(name, sizeof(name), "to CSV, 4 MB chunks, %u thread(s)", n);
+      report(name, t, length);
+      if(n == 1){
+          single_bytes = out_bytes;
+      }
+      ok &= summary.stats.frames == good && summary.stats.crc_errors == stats.crc_errors &&
+            summary.stats.skipped_bytes == stats.skipped_bytes && out_bytes == single_bytes &&
+            summary.log_undecoded == 0;
+  }
+  printf("%llu CRC errors, %llu bad lengths, %llu bytes skipped, %llu frames lost by sequence number\n",
+         (unsigned long long)summary.stats.crc_errors, (unsigned long long)summary.stats.bad_lengths,
+         (unsigned long long)summary.stats.skipped_bytes, (unsigned long long)summary.lost);
+  printf("%s\n", ok ? "all variants agree" : "MISMATCH");
+
+  free(formats.nargs);
+  free(stream);
+  return ok ? 0 : 1;
+}
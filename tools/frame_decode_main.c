@@ -0,0 +1,142 @@
+/*
+ * frame_decode_main.c
+ *
+ * Decodes captures of the bluetooth link or flash dumps into CSV, see frame_decode.h
+ *
+ *   gcc -O2 -pthread -I"src/Header Files" -Itools/host tools/frame_decode.c tools/frame_decode_main.c -o frame_decode
+ *   ./frame_decode [-e firmware.axf] [-o prefix] [-j threads] [-c chunk_mb] capture...
+ *
+ * Writes <prefix>_log.csv (source,seq,time_ms,text), <prefix>_history.csv (source,seq,time_ms,value) and
+ * <prefix>_replay.bin (replay payloads in order, a flash image when the capture holds one replay). Without -e the log
+ * frames are counted but not turned into text. The frame counts, errors and the decode rate go to stderr.
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame_decode.h"
+
+typedef struct {
+  FILE          *log;
+  FILE          *history;
+  FILE          *replay;
+} OUTPUTS;
+
+static void write_chunk(const FRAME_DEC_CHUNK *chunk, void *ctx){
+  OUTPUTS *out = ctx;
+
+  fwrite(chunk->log_csv.data, 1, chunk->log_csv.len, out->log);
+  fwrite(chunk->history_csv.data, 1, chunk->history_csv.len, out->history);
+  fwrite(chunk->replay.data, 1, chunk->replay.len, out->replay);
+}
+
+static FILE *open_output(const char *prefix, const char *suffix, const char *header){
+  char path[4096];
+  FILE *f;
+
+  snprintf(path, sizeof(path), "%s%s", prefix, suffix);
+  f = fopen(path, "wb");
+  if(!f){
+      perror(path);
+      exit(1);
+  }
+  if(header){
+      fputs(header, f);
+  }
+  return f;
+}
+
+static void usage(void){
+  fprintf(stderr, "usage: frame_decode [-e firmware.axf] [-o prefix] [-j threads] [-c chunk_mb] capture...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv){
+  const char *elf = NULL, *prefix = "frames";
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t chunk_mb = 8;
+  FRAME_DEC_FORMATS formats = {0};
+  FRAME_DEC_INPUT *inputs;
+  FRAME_DEC_SUMMARY summary;
+  OUTPUTS out;
+  struct timespec t0, t1;
+  int opt, count;
+
+  while((opt = getopt(argc, argv, "e:o:j:c:")) != -1){
+      switch(opt){
+        case 'e': elf = optarg; break;
+        case 'o': prefix = optarg; break;
+        case 'j': threads = atol(optarg); break;
+        case 'c': chunk_mb = strtoul(optarg, NULL, 0); break;
+        default: usage();
+      }
+  }
+  count = argc - optind;
+  if(count < 1 || threads < 1 || chunk_mb < 1){
+      usage();
+  }
+  if(elf && !frame_dec_formats_load(&formats, elf)){
+      fprintf(stderr, "%s: no .log_fmt section, is the linker script the one in autogen/?\n", elf);
+      return 1;
+  }
+
+  inputs = calloc((size_t)count, sizeof(FRAME_DEC_INPUT));
+  for(int i = 0; i < count; i++){
+      const char *path = argv[optind + i];
+      struct stat st;
+      int fd = open(path, O_RDONLY);
+      if(fd < 0 || fstat(fd, &st) < 0){
+          perror(path);
+          return 1;
+      }
+      inputs[i].name = path;
+      inputs[i].size = (size_t)st.st_size;
+      if(inputs[i].size){
+          inputs[i].data = mmap(NULL, inputs[i].size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if(inputs[i].data == MAP_FAILED){
+              perror(path);
+              return 1;
+          }
+          madvise((void *)inputs[i].data, inputs[i].size, MADV_SEQUENTIAL);
+      }
+      close(fd);
+  }
+
+  out.log = open_output(prefix, "_log.csv", "source,seq,time_ms,text\n");
+  out.history = open_output(prefix, "_history.csv", "source,seq,time_ms,value\n");
+  out.replay = open_output(prefix, "_replay.bin", NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  frame_dec_decode(inputs, (size_t)count, elf ? &formats : NULL, chunk_mb << 20, (unsigned)threads, write_chunk, &out,
+                   &summary);
+  fclose(out.log);
+  fclose(out.history);
+  fclose(out.replay);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  fprintf(stderr, "%llu frames, %llu payload bytes from %llu bytes in %d file(s)\n",
+          (unsigned long long)summary.stats.frames, (unsigned long long)summary.stats.payload_bytes,
+          (unsigned long long)summary.bytes, count);
+  fprintf(stderr, "%llu CRC errors, %llu bad lengths, %llu bytes skipped, %llu frames lost by sequence number\n",
+          (unsigned long long)summary.stats.crc_errors, (unsigned long long)summary.stats.bad_lengths,
+          (unsigned long long)summary.stats.skipped_bytes, (unsigned long long)summary.lost);
+  if(summary.log_undecoded){
+      fprintf(stderr, "%llu log frames not fully decoded%s\n", (unsigned long long)summary.log_undecoded,
+              elf ? " (unknown ids, is the ELF the one the device runs?)" : " (no -e firmware.axf)");
+  }
+  fprintf(stderr, "%.3f s, %.1f MB/s on %ld thread(s)\n", seconds, summary.bytes / 1e6 / seconds, threads);
+
+  for(int i = 0; i < count; i++){
+      if(inputs[i].size){
+          munmap((void *)inputs[i].data, inputs[i].size);
+      }
+  }
+  free(inputs);
+  frame_dec_formats_free(&formats);
+  return 0;
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Generate the cyclic executive frame table and check it is schedulable.
+
+usage: gen_cyclic_schedule.py <schedule.cfg> <output.h> <output.c>
+
+Every job is placed in the minor frames given by its period and offset. The sum of
+the declared worst case execution times of the jobs in a frame, plus the margin, must
+fit in the minor frame or the generator fails and nothing is written.
+"""
+import math
+import sys
+
+
+def parse(path):
+    cfg = {"minor_frame": None, "margin": 0, "jobs": []}
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            key, args = line[0], line[1:]
+            if key in ("minor_frame", "margin") and len(args) == 1:
+                cfg[key] = int(args[0])
+            elif key == "job" and len(args) == 4:
+                cfg["jobs"].append({"name": args[0], "period": int(args[1]),
+                                    "offset": int(args[2]), "wcet": int(args[3])})
+            else:
+                sys.exit("%s:%d: can't parse '%s'" % (path, lineno, " ".join(line)))
+    if not cfg["minor_frame"] or not cfg["jobs"]:
+        sys.exit("%s: minor_frame and at least one job are required" % path)
+    return cfg
+
+
+def schedule(cfg):
+    minor = cfg["minor_frame"]
+    errors = []
+    for job in cfg["jobs"]:
+        if job["period"] % minor or job["offset"] % minor or job["offset"] >= job["period"]:
+            errors.append("%s: period and offset must be multiples of the %d ms minor frame, offset < period"
+                          % (job["name"], minor))
+    if errors:
+        sys.exit("\n".join(errors))
+
+    major = 1
+    for job in cfg["jobs"]:
+        major = major * job["period"] // math.gcd(major, job["period"])
+    frames = [[] for _ in range(major // minor)]
+    for index, job in enumerate(cfg["jobs"]):
+        for start in range(job["offset"], major, job["period"]):
+            frames[start // minor].append(index)
+
+    budget = minor * 1000
+    for n, frame in enumerate(frames):
+        load = sum(cfg["jobs"][i]["wcet"] for i in frame) + cfg["margin"]
+        if load > budget:
+            errors.append("frame %d overruns: %d us of jobs + margin in a %d us frame (%s)"
+                          % (n, load, budget, ", ".join(cfg["jobs"][i]["name"] for i in frame)))
+    if errors:
+        sys.exit("\n".join(errors))
+    return major, frames
+
+
+def banner(name, cfg, major, frames, source):
+    minor = cfg["minor_frame"]
+    out = ["/**", " * @file", " * %s" % name, " * @brief",
+           " * Cyclic executive frame table, generated by tools/gen_cyclic_schedule.py from %s." % source,
+           " * Do not edit, change the schedule file and regenerate.", " *",
+           " * minor frame %d ms, major frame %d ms, margin %d us" % (minor, major, cfg["margin"])]
+    for n, frame in enumerate(frames):
+        load = sum(cfg["jobs"][i]["wcet"] for i in frame)
+        out.append(" * frame %d: %6d us of %d us (%s)" % (n, load, minor * 1000,
+                                                      ", ".join(cfg["jobs"][i]["name"] for i in frame) or "idle"))
+    out.append(" */")
+    out.append("")
+    return out
+
+
+def emit(cfg, major, frames, h_path, c_path, source):
+    width = max(len(f) for f in frames) + 1
+
+    out = banner("cyclic_schedule.h", cfg, major, frames, source)
+    out.append("#ifndef CYCLIC_SCHEDULE_HG")
+    out.append("#define CYCLIC_SCHEDULE_HG")
+    out.append("")
+    out.append("#define CYCLIC_MINOR_FRAME_MS  %d" % cfg["minor_frame"])
+    out.append("#define CYCLIC_MINOR_FRAMES    %d" % len(frames))
+    out.append("#define CYCLIC_FRAME_SLOTS     %d" % width)
+    out.append("#define CYCLIC_JOBS            %d" % len(cfg["jobs"]))
+    out.append("")
+    out.append("#endif")
+    with open(h_path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+    out = banner("cyclic_schedule.c", cfg, major, frames, source)
+    out.append('#include "cyclic_exec.h"')
+    out.append('#include "app.h"')
+    out.append("")
+    out.append("const CYCLIC_JOB cyclic_jobs[CYCLIC_JOBS] = {")
+    for job in cfg["jobs"]:
+        out.append("  { %-24s %6d },  // period %d ms, offset %d ms"
+                   % (job["name"] + ",", job["wcet"], job["period"], job["offset"]))
+    out.append("};")
+    out.append("")
+    out.append("const uint8_t cyclic_frames[CYCLIC_MINOR_FRAMES][CYCLIC_FRAME_SLOTS] = {")
+    for frame in frames:
+        slots = [str(i) for i in frame] + ["CYCLIC_END"]
+        out.append("  { %s }," % ", ".join(slots))
+    out.append("};")
+    with open(c_path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    cfg = parse(sys.argv[1])
+    major, frames = schedule(cfg)
+    emit(cfg, major, frames, sys.argv[2], sys.argv[3], sys.argv[1].split("/")[-1])
+    print("schedulable: %d jobs, %d minor frames of %d ms" % (len(cfg["jobs"]), len(frames), cfg["minor_frame"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Compile the alert rules into the bytecode table evaluated by rules.c.
+
+usage: gen_rules.py <rules.cfg> <output.c>
+
+Each condition is parsed into postfix opcodes and checked the same way rules_open()
+checks it on the device, so a table that compiles here never trips the asserts there.
+"""
+import re
+import struct
+import sys
+
+OPS = {"value": 0x01, "rate": 0x02, "const": 0x03, "<": 0x04, ">": 0x05, "<=": 0x06, ">=": 0x07,
+       "and": 0x08, "or": 0x09, "not": 0x0A, "window": 0x0B}
+HEADER_SIZE = 5
+STACK_DEPTH = 8
+SENSOR_MAX = 8
+RULES_MAX = 16
+TOKEN = re.compile(r"\s*(<=|>=|<|>|\(|\)|-?\d+:\d+|-?\d+|[a-z]+)")
+
+
+def tokenize(text):
+    pos, tokens = 0, []
+    text = text.strip()
+    while pos < len(text):
+        m = TOKEN.match(text, pos)
+        if not m:
+            raise ValueError("unexpected '%s'" % text[pos:])
+        tokens.append(m.group(1))
+        pos = m.end()
+    return tokens
+
+
+class Parser:
+    """or_expr := and_expr ('or' and_expr)*, and_expr := unary ('and' unary)*,
+    unary := 'not' unary | '(' or_expr ')' | 'window' HH:MM HH:MM | term [cmp term]"""
+
+    def __init__(self, tokens):
+        self.tokens, self.pos, self.code = tokens, 0, bytearray()
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else None
+
+    def take(self, expect=None):
+        tok = self.peek()
+        if tok is None or (expect and tok != expect):
+            raise ValueError("expected %s" % (expect or "more input"))
+        self.pos += 1
+        return tok
+
+    def parse(self):
+        self.or_expr()
+        if self.peek() is not None:
+            raise ValueError("unexpected '%s'" % self.peek())
+        return bytes(self.code)
+
+    def or_expr(self):
+        self.and_expr()
+        while self.peek() == "or":
+            self.take()
+            self.and_expr()
+            self.code.append(OPS["or"])
+
+    def and_expr(self):
+        self.unary()
+        while self.peek() == "and":
+            self.take()
+            self.unary()
+            self.code.append(OPS["and"])
+
+    def unary(self):
+        tok = self.peek()
+        if tok == "not":
+            self.take()
+            self.unary()
+            self.code.append(OPS["not"])
+        elif tok == "(":
+            self.take()
+            self.or_expr()
+            self.take(")")
+        elif tok == "window":
+            self.take()
+            start, stop = minute(self.take()), minute(self.take())
+            if start == 1440:
+                raise ValueError("window must start before 24:00")
+            self.code.append(OPS["window"])
+            self.code += struct.pack("<HH", start, stop)
+        else:
+            self.term()
+            if self.peek() in ("<", ">", "<=", ">="):
+                op = self.take()
+                self.term()
+                self.code.append(OPS[op])
+
+    def term(self):
+        tok = self.take()
+        if tok in ("value", "rate"):
+            self.code.append(OPS[tok])
+        elif re.fullmatch(r"-?\d+", tok):
+            self.code.append(OPS["const"])
+            self.code += struct.pack("<i", int(tok))
+        else:
+            raise ValueError("unexpected '%s'" % tok)
+
+
+def minute(tok):
+    m = re.fullmatch(r"(\d+):(\d+)", tok)
+    if not m or int(m.group(1)) > 24 or int(m.group(2)) > 59:
+        raise ValueError("bad time '%s', use HH:MM" % tok)
+    value = int(m.group(1)) * 60 + int(m.group(2))
+    if value > 1440:
+        raise ValueError("bad time '%s'" % tok)
+    return value
+
+
+def check_depth(code):
+    depth, i = 0, 0
+    while i < len(code):
+        op = code[i]
+        i += 1
+        if op in (OPS["value"], OPS["rate"]):
+            depth += 1
+        elif op in (OPS["const"], OPS["window"]):
+            depth += 1
+            i += 4
+        elif op == OPS["not"]:
+            pass
+        else:
+            depth -= 1
+        if depth > STACK_DEPTH:
+            raise ValueError("condition needs more than %d stack entries" % STACK_DEPTH)
+    if depth != 1:
+        raise ValueError("condition must produce a single value")
+
+
+def parse(path):
+    rules = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            text = line.split("#", 1)[0].strip()
+            comment = line.split("#", 1)[1].strip() if "#" in line else ""
+            if not text:
+                continue
+            fields = text.split(None, 4)
+            try:
+                if fields[0] != "rule" or len(fields) != 5:
+                    raise ValueError("expected: rule <id> <sensor id> <hold s> <condition>")
+                rule_id, sensor, hold = int(fields[1]), int(fields[2]), int(fields[3])
+                if not (0 <= rule_id < 256 and 0 <= sensor < SENSOR_MAX and 0 <= hold < 65536):
+                    raise ValueError("id, sensor id or hold out of range")
+                code = Parser(tokenize(fields[4])).parse()
+                check_depth(code)
+                record = struct.pack("<BBBH", HEADER_SIZE + len(code), rule_id, sensor, hold) + code
+                if len(record) > 255:
+                    raise ValueError("condition too long")
+            except (ValueError, IndexError) as e:
+                sys.exit("%s:%d: %s" % (path, lineno, e))
+            rules.append({"id": rule_id, "text": fields[4], "comment": comment, "record": record,
+                          "sensor": sensor, "hold": hold})
+    if len(rules) > RULES_MAX:
+        sys.exit("%s: %d rules, the engine holds %d" % (path, len(rules), RULES_MAX))
+    if len({r["id"] for r in rules}) != len(rules):
+        sys.exit("%s: rule ids must be unique" % path)
+    return rules
+
+
+def emit(rules, c_path, source):
+    size = sum(len(r["record"]) for r in rules) + 1
+    out = ["/**", " * @file", " * rules_config.c", " * @brief",
+           " * Alert rule table, generated by tools/gen_rules.py from %s." % source,
+           " * Do not edit, change the rules file and regenerate.", " *",
+           " * %d rules, %d bytes" % (len(rules), size), " */", "",
+           '#include "rules.h"', "", "const uint8_t rules_bytecode[] = {"]
+    for r in rules:
+        out.append("  // rule %d, sensor %d, hold %d s: %s%s" % (r["id"], r["sensor"], r["hold"], r["text"],
+                                                                 " (%s)" % r["comment"] if r["comment"] else ""))
+        rec = r["record"]
+        for i in range(0, len(rec), 12):
+            out.append("  " + " ".join("0x%02X," % b for b in rec[i:i + 12]))
+    out.append("  0x00  // end of table")
+    out.append("};")
+    with open(c_path, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    rules = parse(sys.argv[1])
+    emit(rules, sys.argv[2], sys.argv[1].split("/")[-1])
+    print("compiled %d rules" % len(rules))
+
+
+if __name__ == "__main__":
+    main()
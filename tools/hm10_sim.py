@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Simulate the HM10 link under each radio profile in ble.c.
+
+usage: hm10_sim.py [ble.c] [--grant min|max] [--packets-per-event N] [--buffer BYTES]
+                   [--bulk BYTES] [--trials N] [--seed N]
+
+The profiles are read from the ble_profiles[] table in ble.c, so the report follows
+the firmware. A simulated module sits between the 9600 baud LEUART and a central:
+
+  bulk         a replay of --bulk bytes in 250 byte frames arrives over the UART at
+               960 B/s, the module sends up to --packets-per-event notifications of
+               20 bytes on each connection event and drops what overflows --buffer.
+               Throughput is payload bytes over the time the last byte reaches the
+               central.
+  latency      the central writes a 20 byte command at a random time and the device
+               answers with 20 bytes. With slave latency the module only listens on
+               every (latency + 1)th event, the answer goes out on the next event
+               after it has come over the UART. Mean and 99th percentile of
+               --trials round trips.
+  radio        connection events per second the module wakes for with nothing to
+               send, and advertising events per second while not connected, as a
+               proxy for the module current.
+  switch       AT commands and time to change from every other profile, only
+               parameters that differ are sent, plus AT+RESET.
+
+The central grants the interval at the --grant end of the AT+COMI..AT+COMA range.
+One notification per event is the conservative default for the CC2541 firmware.
+"""
+import argparse
+import os
+import random
+import re
+import sys
+
+UART_BPS = 960.0                  # 9600 baud, 10 bits per byte
+NOTIFY_BYTES = 20                 # ATT payload of one notification
+FRAME_BYTES = 250                 # replay frame, 240 byte payload
+AT_REPLY_MS = 20.0                # module processing time of an AT command
+AT_RESET_MS = 1000.0              # BLE_AT_RESET_MS
+ADVI_MS = [100, 152.5, 211.25, 318.75, 417.5, 546.25, 760, 852.5, 1022.5, 1285,
+           2000, 3000, 4000, 5000, 6000, 7000]
+POWE_DBM = [-23, -6, 0, 6]
+CONN_MS = [7.5, 10, 15, 20, 25, 30, 35, 40, 45, 4000]
+PROFILE = re.compile(r"\[ble_profile_(\w+)\]\s*=\s*\{(.*?)\}", re.S)
+PARAM = re.compile(r"\[ble_param_(\w+)\]\s*=\s*(0x[0-9a-fA-F]+|\d+)")
+
+
+def load_profiles(path):
+    text = open(path).read()
+    table = text[text.index("ble_profiles[ble_profile_count]"):]
+    table = table[:table.index("};")]
+    profiles = {}
+    for name, body in PROFILE.findall(table):
+        profiles[name] = {p: int(v, 0) for p, v in PARAM.findall(body)}
+    if not profiles:
+        sys.exit("%s: no ble_profiles[] table" % path)
+    return profiles
+
+
+def interval_ms(profile, grant):
+    if "conn_min" not in profile:
+        return CONN_MS[7]          # module default without AT+COMI/COMA support, 40 ms
+    lo, hi = CONN_MS[profile["conn_min"]], CONN_MS[profile["conn_max"]]
+    return lo if grant == "min" else hi
+
+
+def bulk(profile, args):
+    interval = interval_ms(profile, args.grant)
+    total, sent, dropped, t = args.bulk, 0, 0, 0.0
+    per_event = args.packets_per_event * NOTIFY_BYTES
+    buffered = 0
+    arrived_prev = 0
+    while sent + dropped < total:
+        t += interval
+        arrived = min(total, int(t / 1000.0 * UART_BPS))
+        buffered += arrived - arrived_prev
+        arrived_prev = arrived
+        if buffered > args.buffer:
+            dropped += buffered - args.buffer
+            buffered = args.buffer
+        out = min(buffered, per_event)
+        buffered -= out
+        sent += out
+    payload = sent * (FRAME_BYTES - 10) / FRAME_BYTES
+    return payload / (t / 1000.0), dropped, t
+
+
+def latency(profile, args, rng):
+    interval = interval_ms(profile, args.grant)
+    listen = interval * (profile.get("conn_latency", 0) + 1)
+    uart_ms = NOTIFY_BYTES / UART_BPS * 1000.0
+    samples = []
+    for _ in range(args.trials):
+        write = rng.uniform(0, listen)
+        received = (write // listen + 1) * listen            # next event the module listens on
+        answer = received + 2 * uart_ms + 1.0                # command out, answer back, 1 ms on the device
+        sent = (answer // interval + 1) * interval            # next connection event
+        samples.append(sent - write)
+    samples.sort()
+    return sum(samples) / len(samples), samples[int(len(samples) * 0.99) - 1]
+
+
+def switch_cost(frm, to):
+    cmds, ms = 0, 0.0
+    for param, code in to.items():
+        if frm.get(param) != code:
+            cmds += 1
+            ms += (8 + 8) / UART_BPS * 1000.0 + AT_REPLY_MS  # "AT+XXXXn" out, "OK+Set:n" back
+    if cmds:
+        cmds += 1
+        ms += (8 + 8) / UART_BPS * 1000.0 + AT_REPLY_MS + AT_RESET_MS
+    return cmds, ms
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("ble_c", nargs="?", default=os.path.join(here, "..", "src", "Source Files", "ble.c"))
+    ap.add_argument("--grant", choices=("min", "max"), default="max")
+    ap.add_argument("--packets-per-event", type=int, default=1)
+    ap.add_argument("--buffer", type=int, default=256, help="module UART buffer in bytes")
+    ap.add_argument("--bulk", type=int, default=64 * FRAME_BYTES, help="replay bytes on the UART")
+    ap.add_argument("--trials", type=int, default=10000)
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    profiles = load_profiles(args.ble_c)
+    rng = random.Random(args.seed)
+    print("%-16s %8s %6s %6s %10s %8s %10s %10s %10s %10s" % (
+        "profile", "conn ms", "lat", "dBm", "bulk B/s", "dropped", "rtt ms", "rtt p99", "idle ev/s", "adv ev/s"))
+    for name, p in profiles.items():
+        rate, dropped, _ = bulk(p, args)
+        mean, p99 = latency(p, args, rng)
+        interval = interval_ms(p, args.grant)
+        idle = 1000.0 / (interval * (p.get("conn_latency", 0) + 1))
+        print("%-16s %8.1f %6d %6d %10.0f %8d %10.1f %10.1f %10.1f %10.2f" % (
+            name, interval, p.get("conn_latency", 0), POWE_DBM[p["tx_power"]], rate, dropped, mean, p99, idle,
+            1000.0 / ADVI_MS[p["adv_interval"]]))
+
+    print("\nswitch cost (AT commands, ms), rows from, columns to")
+    names = list(profiles)
+    print("%-16s" % "" + "".join("%20s" % n for n in names))
+    for frm in names:
+        cells = []
+        for to in names:
+            cmds, ms = switch_cost(profiles[frm], profiles[to])
+            cells.append("%20s" % ("%d, %.0f" % (cmds, ms)))
+        print("%-16s" % frm + "".join(cells))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,6 @@
+/* Host build of the firmware modules used by the tools, EFM_ASSERT maps to assert() */
+#ifndef EM_ASSERT_H
+#define EM_ASSERT_H
+#include <assert.h>
+#define EFM_ASSERT(expr) assert(expr)
+#endif
@@ -0,0 +1,7 @@
+/* Host build of the firmware modules used by the tools, there are no interrupts to mask */
+#ifndef EM_CORE_H
+#define EM_CORE_H
+#define CORE_DECLARE_IRQ_STATE
+#define CORE_ENTER_CRITICAL()
+#define CORE_EXIT_CRITICAL()
+#endif
@@ -0,0 +1,4 @@
+/* Host build of the firmware modules used by the tools, energy modes are not modelled */
+#ifndef EM_EMU_H
+#define EM_EMU_H
+#endif
@@ -0,0 +1,117 @@
+/*
+ * i2c_slave_sim.c
+ *
+ * Host simulation of the I2C0 slave in src/Source Files/i2c.c against the register model in tools/host/em_i2c.h
+ *
+ *   gcc -O2 -I"src/Header Files" -I"src/Source Files" -Itools/host tools/i2c_slave_sim.c -o i2c_slave_sim
+ *   ./i2c_slave_sim
+ *
+ * The host side of each transaction is played into the model the way the peripheral raises it: an address match puts
+ * the address byte in the receive buffer with ADDR and RXDATAV in the same interrupt, a written byte raises RXDATAV,
+ * the host's ACK of a read byte raises ACK. For every register of the map a write of the register pointer followed by
+ * a repeated start read of the rest of the map is checked byte for byte, and no read may find the receive buffer
+ * empty. i2c.c is included so the static slave_open() can be called without the master setup of i2c_open().
+ */
+#include <stdio.h>
+#include <string.h>
+#include "i2c.c"
+
+#define SIM_ADDRESS   0x55
+#define SIM_RX_DEPTH  2               // receive buffer of the part
+
+I2C_TypeDef i2c0_model, i2c1_model;
+
+static uint8_t  rx_buf[SIM_RX_DEPTH];
+static uint32_t rx_count;
+static uint32_t rx_underflows;
+static int32_t  em_blocks;
+
+static uint32_t model_rxdata_read(void){
+  uint32_t data;
+
+  if(rx_count == 0){
+      rx_underflows++;
+      return 0xFF; //RXUF, the part returns stale data
+  }
+  data = rx_buf[0];
+  rx_buf[0] = rx_buf[1];
+  if(--rx_count == 0){
+      i2c0_model.STATUS &= ~I2C_STATUS_RXDATAV;
+  }
+  return data;
+}
+
+static void model_rx_push(uint8_t data){
+  rx_buf[rx_count++] = data;
+  i2c0_model.STATUS |= I2C_STATUS_RXDATAV;
+}
+
+static void model_irq(uint32_t flags){
+  i2c0_model.IF = flags;
+  I2C0_IRQHandler();
+}
+
+void sleep_block_mode(uint32_t EM){
+  (void)EM;
+  em_blocks++;
+}
+
+void sleep_unblock_mode(uint32_t EM){
+  (void)EM;
+  em_blocks--;
+}
+
+void add_scheduled_event(uint32_t event){
+  (void)event;
+}
+
+// Address match of a transaction, the address byte and the match arrive in one interrupt
+static void host_address(OPERATION_MODE mode){
+  model_rx_push((SIM_ADDRESS << 1) | mode);
+  model_irq(I2C_IF_ADDR | I2C_IF_RXDATAV);
+}
+
+static void host_write(uint8_t data){
+  model_rx_push(data);
+  model_irq(I2C_IF_RXDATAV);
+}
+
+// Takes the byte loaded in TXDATA and acks it for the next one, or nacks the last one
+static uint8_t host_read(bool last){
+  uint8_t data = (uint8_t)i2c0_model.TXDATA;
+
+  model_irq(last ? I2C_IF_NACK : I2C_IF_ACK);
+  return data;
+}
+
+int main(void){
+  uint8_t map[I2C_SLAVE_MAP_SIZE];
+  uint32_t errors = 0;
+
+  i2c0_model.rxdata_read = model_rxdata_read;
+  i2c0_model.IEN = I2C_IEN_ADDR | I2C_IEN_RXDATAV | I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_SSTOP | I2C_IEN_BUSERR;
+  slave_open(I2C0, SIM_ADDRESS);
+  for(uint32_t i = 0; i < I2C_SLAVE_MAP_SIZE; i++){
+      map[i] = (uint8_t)(0xA0 + i);
+  }
+  i2c_slave_publish(I2C0, map, sizeof(map));
+
+  for(uint32_t reg = 0; reg < I2C_SLAVE_MAP_SIZE; reg++){
+      host_address(write);
+      host_write((uint8_t)reg);
+      host_address(read); //repeated start
+      for(uint32_t i = reg; i < I2C_SLAVE_MAP_SIZE; i++){
+          uint8_t data = host_read(i == I2C_SLAVE_MAP_SIZE - 1);
+          if(data != map[i]){
+              printf("reg %u: byte %u read 0x%02X, expected 0x%02X\n", reg, i, data, map[i]);
+              errors++;
+              break;
+          }
+      }
+      model_irq(I2C_IF_SSTOP);
+  }
+
+  printf("%u transactions, %u receive buffer underflows, %u mismatches, %d EM2 blocks left\n",
+         i2c0_slave.transactions, rx_underflows, errors, em_blocks);
+  return errors || rx_underflows || em_blocks ? 1 : 0;
+}
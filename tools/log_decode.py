@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Rebuild the text of LOG() records from a capture of the bluetooth link.
+
+usage: log_decode.py <firmware.axf> [capture|-]
+
+The format strings are read from the .log_fmt section of the ELF, the id of a record is
+the offset of its string in that section. The capture is scanned for frames (A5 5A sync,
+CRC-32 checked), frames of other types and bytes between frames are skipped, and each
+log record is printed with the device time of the flush that sent it. The ELF must be
+the one the device is running, a record whose id is not the start of a string is
+reported and the rest of that frame is dropped.
+"""
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+from ram_bank_report import Elf32
+
+FRAME_SYNC = b"\xA5\x5A"
+FRAME_HEADER_SIZE = 6
+FRAME_TRAILER_SIZE = 4
+FRAME_PAYLOAD_MAX = 1024
+FRAME_TYPE_LOG = 2
+LOG_ID_DROPPED = 0xFFFF
+CONVERSION = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)([diuxXc%])")
+
+
+class Formats:
+    """Format strings of the .log_fmt section, by id."""
+
+    def __init__(self, elf):
+        section = elf.section(".log_fmt")
+        if section is None:
+            sys.exit("no .log_fmt section, is the linker script the one in autogen/?")
+        self.data = elf.data[section["offset"]:section["offset"] + section["size"]]
+        self.cache = {}
+
+    def get(self, log_id):
+        if log_id not in self.cache:
+            if log_id >= len(self.data) or (log_id and self.data[log_id - 1] != 0):
+                return None
+            end = self.data.index(b"\0", log_id)
+            fmt = self.data[log_id:end].decode(errors="replace")
+            kinds = [kind for _, kind in CONVERSION.findall(fmt) if kind != "%"]
+            self.cache[log_id] = (CONVERSION.sub(self._python_spec, fmt), kinds)
+        return self.cache[log_id]
+
+    @staticmethod
+    def _python_spec(m):
+        kind = m.group(2)
+        return "%" + m.group(1) + ("d" if kind in "iu" else kind)
+
+
+def arg_value(kind, word):
+    if kind in "di":
+        return word - (1 << 32) if word & 0x80000000 else word
+    if kind == "c":
+        return word & 0xFF
+    return word
+
+
+def decode_payload(payload, formats, out):
+    (time_ms,) = struct.unpack_from("<I", payload, 0)
+    pos = 4
+    while pos + 2 <= len(payload):
+        (log_id,) = struct.unpack_from("<H", payload, pos)
+        pos += 2
+        if log_id == LOG_ID_DROPPED:
+            (count,) = struct.unpack_from("<I", payload, pos)
+            pos += 4
+            out.write("%10.3f  <%d records dropped>\n" % (time_ms / 1000, count))
+            continue
+        entry = formats.get(log_id)
+        if entry is None or pos + 4 * len(entry[1]) > len(payload):
+            out.write("%10.3f  <unknown log id 0x%04x, frame dropped>\n" % (time_ms / 1000, log_id))
+            return
+        fmt, kinds = entry
+        words = struct.unpack_from("<%dI" % len(kinds), payload, pos)
+        pos += 4 * len(kinds)
+        text = fmt % tuple(arg_value(k, w) for k, w in zip(kinds, words))
+        out.write("%10.3f  %s\n" % (time_ms / 1000, text.rstrip("\n")))
+
+
+def frames(data):
+    """Yields (type, seq, payload) of every frame whose CRC matches."""
+    pos = 0
+    while True:
+        pos = data.find(FRAME_SYNC, pos)
+        if pos < 0 or pos + FRAME_HEADER_SIZE > len(data):
+            return
+        ftype, seq, length = struct.unpack_from("<BBH", data, pos + 2)
+        end = pos + FRAME_HEADER_SIZE + length
+        if length > FRAME_PAYLOAD_MAX or end + FRAME_TRAILER_SIZE > len(data):
+            pos += 1
+            continue
+        (crc,) = struct.unpack_from("<I", data, end)
+        if zlib.crc32(data[pos + 2:end]) != crc:
+            pos += 1  # sync bytes inside other data, keep scanning
+            continue
+        yield ftype, seq, data[pos + FRAME_HEADER_SIZE:end]
+        pos = end + FRAME_TRAILER_SIZE
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf")
+    ap.add_argument("capture", nargs="?", default="-")
+    args = ap.parse_args()
+
+    formats = Formats(Elf32(args.elf))
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+
+    expected = None
+    for ftype, seq, payload in frames(data):
+        if ftype != FRAME_TYPE_LOG:
+            continue
+        if expected is not None and seq != expected:
+            sys.stdout.write("<%d log frames lost>\n" % ((seq - expected) & 0xFF))
+        expected = (seq + 1) & 0xFF
+        decode_payload(payload, formats, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+/*
+ * lttb_bench.c
+ *
+ * Host benchmark of the streaming LTTB in src/Source Files/lttb.c
+ *
+ *   gcc -O2 -I"src/Header Files" -Itools/host tools/lttb_bench.c "src/Source Files/lttb.c" -o lttb_bench -lm
+ *   ./lttb_bench [out_points]
+ *
+ * A light-like signal sampled every 2 s (daylight curve, sensor noise and single sample spikes) is downsampled from
+ * 10k to 100k points. The streaming pass is timed and compared with a reference LTTB that holds the whole input in
+ * memory, and the spikes that survive are counted for LTTB and for plain decimation to the same number of points.
+ *
+ * Target numbers come from LTTB_BENCHMARK_ON_BOOT in app.h, which runs the same sizes on the device and logs the
+ * cycles per point.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "lttb.h"
+
+#define SAMPLE_MS       2000
+#define SPIKE_EVERY     2000
+#define SPIKE_HEIGHT    800
+#define REPEATS         20
+
+static double now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_signal(LTTB_POINT *in, uint32_t n){
+  srand(1);
+  for(uint32_t i = 0; i < n; i++){
+      double day = 2 * M_PI * ((double)i * SAMPLE_MS / 86400000.0);
+      int32_t v = (int32_t)(500 + 400 * sin(day)) + rand() % 11 - 5;
+      if(i % SPIKE_EVERY == SPIKE_EVERY / 2){
+          v += SPIKE_HEIGHT;
+      }
+      in[i].timestamp = 1000000 + i * SAMPLE_MS;
+      in[i].value = v;
+  }
+}
+
+/* Classic LTTB over an array, as published, used as the reference */
+static uint32_t lttb_reference(const LTTB_POINT *in, uint32_t n, LTTB_POINT *out, uint32_t threshold){
+  double every = (double)(n - 2) / (threshold - 2);
+  uint32_t a = 0, k = 0;
+
+  out[k++] = in[0];
+  for(uint32_t i = 0; i < threshold - 2; i++){
+      uint32_t start = (uint32_t)floor((i + 1) * every) + 1;
+      uint32_t end = (uint32_t)floor((i + 2) * every) + 1;
+      double avg_t = 0, avg_v = 0;
+      if(end > n){
+          end = n;
+      }
+      for(uint32_t j = start; j < end; j++){
+          avg_t += (double)in[j].timestamp - in[0].timestamp;
+          avg_v += in[j].value;
+      }
+      avg_t = floor(avg_t / (end - start) + 0.5);
+      avg_v = floor(avg_v / (end - start) + 0.5);
+
+      uint32_t range = (uint32_t)floor(i * every) + 1, range_end = (uint32_t)floor((i + 1) * every) + 1;
+      double best = -1;
+      uint32_t best_j = range;
+      double at = (double)in[a].timestamp - in[0].timestamp, av = in[a].value;
+      for(uint32_t j = range; j < range_end; j++){
+          double pt = (double)in[j].timestamp - in[0].timestamp;
+          double area = fabs((pt - at) * (avg_v - av) - (in[j].value - av) * (avg_t - at));
+          if(area > best){
+              best = area;
+              best_j = j;
+          }
+      }
+      out[k++] = in[best_j];
+      a = best_j;
+  }
+  out[k++] = in[n - 1];
+  return k;
+}
+
+static uint32_t spikes_kept(const LTTB_POINT *out, uint32_t count){
+  uint32_t kept = 0;
+  for(uint32_t i = 0; i < count; i++){
+      uint32_t index = (out[i].timestamp - 1000000) / SAMPLE_MS;
+      kept += (index % SPIKE_EVERY == SPIKE_EVERY / 2);
+  }
+  return kept;
+}
+
+int main(int argc, char **argv){
+  static const uint32_t sizes[] = {10000, 20000, 50000, 100000};
+  uint32_t out_points = argc > 1 ? (uint32_t)atoi(argv[1]) : 500;
+  LTTB_POINT *in = malloc(sizeof(LTTB_POINT) * 100000);
+  LTTB_POINT *out = malloc(sizeof(LTTB_POINT) * out_points);
+  LTTB_POINT *ref = malloc(sizeof(LTTB_POINT) * out_points);
+  LTTB_POINT *dec = malloc(sizeof(LTTB_POINT) * out_points);
+  LTTB_STATE lttb;
+
+  printf("%8s %6s %10s %10s %8s %8s %14s %10s\n", "in", "out", "stream ns", "ref ns", "match", "spikes",
+         "lttb/decimate", "hull drop");
+  for(uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+      uint32_t n = sizes[s], count = 0, ref_count, match = 0, spikes = n / SPIKE_EVERY;
+      double t0, stream_ns, ref_ns;
+
+      make_signal(in, n);
+      t0 = now_ns();
+      for(int r = 0; r < REPEATS; r++){
+          lttb_open(&lttb, n, out, out_points);
+          for(uint32_t i = 0; i < n; i++){
+              lttb_push(&lttb, &in[i]);
+          }
+          count = lttb_close(&lttb);
+      }
+      stream_ns = (now_ns() - t0) / REPEATS / n;
+
+      t0 = now_ns();
+      for(int r = 0; r < REPEATS; r++){
+          ref_count = lttb_reference(in, n, ref, out_points);
+      }
+      ref_ns = (now_ns() - t0) / REPEATS / n;
+
+      for(uint32_t i = 0; i < count && i < ref_count; i++){
+          match += (out[i].timestamp == ref[i].timestamp);
+      }
+      for(uint32_t i = 0; i < out_points; i++){
+          dec[i] = in[(uint64_t)i * (n - 1) / (out_points - 1)];
+      }
+      printf("%8u %6u %10.1f %10.1f %7.1f%% %8u %6u/%-7u %10u\n", n, count, stream_ns, ref_ns,
+             100.0 * match / ref_count, spikes, spikes_kept(out, count), spikes_kept(dec, out_points), lttb.hull_drops);
+  }
+  free(in);
+  free(out);
+  free(ref);
+  free(dec);
+  return 0;
+}
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Report how much of each RAM block the firmware uses.
+
+usage: ram_bank_report.py <firmware.axf> [--ram-base 0x20000000] [--banks 32768,...]
+
+The sections that are allocated in RAM are read from the ELF section headers and the
+bytes used in each RAM block are listed, along with the blocks that ram_open() powers
+down (every block that lies completely above __ram_used_end__), and the heap size with
+any allocator that was linked in (none may be in a SL_HEAP_FREE build). The default block
+layout is eight 32 KB blocks, check it against the RAM block table in the reference
+manual of the part and pass --banks if it differs.
+"""
+import argparse
+import struct
+import sys
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+ALLOCATORS = ("malloc", "_malloc_r", "calloc", "_calloc_r", "realloc", "_realloc_r")  # not _sbrk, sl_memory.c always defines it
+
+
+class Elf32:
+    """Minimal little endian ELF32 reader, only the section and symbol tables."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            sys.exit("%s: not a little endian ELF32 file" % path)
+        (self.shoff,) = struct.unpack_from("<I", self.data, 0x20)
+        self.shentsize, self.shnum, self.shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+        self.sections = [self._section(i) for i in range(self.shnum)]
+        names = self.sections[self.shstrndx]
+        for s in self.sections:
+            s["name"] = self._str(names["offset"] + s["name_off"])
+
+    def _section(self, i):
+        fields = struct.unpack_from("<IIIIIIIIII", self.data, self.shoff + i * self.shentsize)
+        keys = ("name_off", "type", "flags", "addr", "offset", "size", "link", "info", "align", "entsize")
+        return dict(zip(keys, fields))
+
+    def _str(self, off):
+        return self.data[off:self.data.index(b"\0", off)].decode()
+
+    def section(self, name):
+        for s in self.sections:
+            if s["name"] == name:
+                return s
+        return None
+
+    def symbols(self):
+        symtab = self.section(".symtab")
+        if symtab is None:
+            return {}
+        strtab = self.sections[symtab["link"]]
+        syms = {}
+        for off in range(symtab["offset"], symtab["offset"] + symtab["size"], 16):
+            name_off, value, size, info, other, shndx = struct.unpack_from("<IIIBBH", self.data, off)
+            if name_off:
+                syms[self._str(strtab["offset"] + name_off)] = value
+        return syms
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf")
+    ap.add_argument("--ram-base", type=lambda v: int(v, 0), default=0x20000000)
+    ap.add_argument("--banks", default=",".join(["32768"] * 8),
+                    help="comma separated RAM block sizes in bytes, lowest address first")
+    args = ap.parse_args()
+
+    elf = Elf32(args.elf)
+    sizes = [int(v, 0) for v in args.banks.split(",")]
+    banks, base = [], args.ram_base
+    for size in sizes:
+        banks.append((base, base + size))
+        base += size
+    ram_end = base
+
+    ram = [s for s in elf.sections
+           if s["flags"] & SHF_ALLOC and s["size"] and args.ram_base <= s["addr"] < ram_end]
+    used = [0] * len(banks)
+    print("%-16s %-10s %8s" % ("section", "address", "bytes"))
+    for s in sorted(ram, key=lambda s: s["addr"]):
+        print("%-16s 0x%08x %8d" % (s["name"], s["addr"], s["size"]))
+        start, end = s["addr"], s["addr"] + s["size"]
+        for i, (lo, hi) in enumerate(banks):
+            used[i] += max(0, min(end, hi) - max(start, lo))
+
+    syms = elf.symbols()
+    used_end = syms.get("__ram_used_end__")
+    if used_end is None:
+        used_end = max(s["addr"] + s["size"] for s in ram)
+        print("\n__ram_used_end__ not found, using the end of the last RAM section")
+    print("\n__ram_used_end__ = 0x%08x (%d bytes)" % (used_end, used_end - args.ram_base))
+    linked = [name for name in ALLOCATORS if name in syms]
+    if "__heap_size" in syms:
+        print("heap = %d bytes, allocator %s" % (syms["__heap_size"], ", ".join(linked) if linked else "not linked"))
+    print()
+
+    print("%-5s %-23s %8s %8s  %s" % ("block", "range", "used", "size", "state"))
+    off = 0
+    for i, (lo, hi) in enumerate(banks):
+        state = "powered down" if lo >= used_end else "retained"
+        if lo >= used_end:
+            off += 1
+        print("%-5d 0x%08x-0x%08x %8d %8d  %s" % (i, lo, hi - 1, used[i], hi - lo, state))
+    print("\n%d of %d blocks powered down by ram_open()" % (off, len(banks)))
+    if off == 0:
+        sys.exit("no RAM blocks can be powered down")
+
+
+if __name__ == "__main__":
+    main()